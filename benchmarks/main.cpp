@@ -0,0 +1,250 @@
+/* Kernel micro-benchmarks of HiPACE++.
+ *
+ * The harness sets up a regular simulation from an input file (Hipace::InitData, without
+ * Evolve), and times the hot kernels in isolation on its data. Each kernel is called once to
+ * warm up, then benchmark.repetitions times, and the average time per call is reported
+ * together with the throughput in particles/s or cells/s.
+ */
+#include "Hipace.H"
+#include "fields/Fields.H"
+#include "fields/fft_poisson_solver/FFTPoissonSolverDirichlet.H"
+#include "particles/BinSort.H"
+#include "particles/BoxSort.H"
+#include "particles/PlasmaParticleContainer.H"
+#include "particles/deposition/PlasmaDepositCurrent.H"
+#include "particles/pusher/BeamParticleAdvance.H"
+#include "particles/pusher/FieldGather.H"
+#include "particles/pusher/GetAndSetPosition.H"
+#include "particles/pusher/PlasmaParticleAdvance.H"
+#include "utils/HipaceProfilerWrapper.H"
+#include "utils/HipaceTracer.H"
+
+#include <AMReX.H>
+#include <AMReX_ParmParse.H>
+#include <AMReX_Print.H>
+
+#include <iomanip>
+#include <string>
+
+namespace
+{
+    /** \brief Average wall time of one call of a kernel, after a warm-up call
+     * \param[in] repetitions number of timed calls
+     * \param[in] kernel function to time
+     */
+    template<typename F>
+    double TimeKernel (const int repetitions, F&& kernel)
+    {
+        kernel();
+        amrex::Gpu::synchronize();
+        const double t_start = amrex::second();
+        for (int i = 0; i < repetitions; ++i) kernel();
+        amrex::Gpu::synchronize();
+        return (amrex::second() - t_start) / repetitions;
+    }
+
+    /** \brief Prints one line of the benchmark table
+     * \param[in] kernel name of the kernel
+     * \param[in] config configuration of the kernel (order, grid size, species)
+     * \param[in] time average time per call
+     * \param[in] n_items number of particles or cells processed per call
+     * \param[in] unit unit of the throughput
+     */
+    void Report (const std::string& kernel, const std::string& config, const double time,
+                 const double n_items, const std::string& unit)
+    {
+        amrex::Print() << std::left << std::setw(32) << kernel << std::setw(20) << config
+                       << std::right << std::scientific << std::setprecision(4)
+                       << std::setw(14) << time << std::setw(14)
+                       << (time > 0. ? n_items/time : 0.) << " " << unit << "\n";
+    }
+
+    /** \brief Times the field gather of all particles of a plasma species on the current slice
+     * \tparam depos_order_xy transverse order of the shape factor
+     * \param[in] plasma plasma species
+     * \param[in] fields the general field class
+     * \param[in] gm Geometry of the simulation
+     * \param[in] repetitions number of timed calls
+     */
+    template<int depos_order_xy>
+    double TimeGather (PlasmaParticleContainer& plasma, Fields& fields,
+                       const amrex::Geometry& gm, const int repetitions)
+    {
+        amrex::Gpu::DeviceVector<amrex::Real> sink;
+        return TimeKernel(repetitions, [&] () {
+            for (PlasmaParticleIterator pti(plasma, 0); pti.isValid(); ++pti)
+            {
+                const amrex::Box tilebox =
+                    pti.tilebox().grow({depos_order_xy, depos_order_xy, 0});
+                const amrex::RealBox grid_box{tilebox, gm.CellSize(), gm.ProbLo()};
+                const amrex::Real* dx = gm.CellSize();
+                const amrex::GpuArray<amrex::Real, 3> dx_arr = {dx[0], dx[1], dx[2]};
+                const amrex::GpuArray<amrex::Real, 3> xyzmin_arr =
+                    {grid_box.lo(0), grid_box.lo(1), grid_box.lo(2)};
+                const amrex::Dim3 lo = amrex::lbound(tilebox);
+
+                const amrex::MultiFab& S = fields.getSlices(0, WhichSlice::This);
+                const auto exmby = S[pti].const_array(Comps[WhichSlice::This]["ExmBy"]);
+                const auto eypbx = S[pti].const_array(Comps[WhichSlice::This]["EypBx"]);
+                const auto ez = S[pti].const_array(Comps[WhichSlice::This]["Ez"]);
+                const auto bx = S[pti].const_array(Comps[WhichSlice::This]["Bx"]);
+                const auto by = S[pti].const_array(Comps[WhichSlice::This]["By"]);
+                const auto bz = S[pti].const_array(Comps[WhichSlice::This]["Bz"]);
+
+                using PTileType = PlasmaParticleContainer::ParticleTileType;
+                const auto getPosition = GetParticlePosition<PTileType>(pti.GetParticleTile());
+                const amrex::Real zmin = xyzmin_arr[2];
+
+                // the gathered fields are summed to a sink so the gather cannot be optimized out
+                sink.resize(pti.numParticles());
+                amrex::Real* const p_sink = sink.dataPtr();
+                amrex::ParallelFor(pti.numParticles(),
+                    [=] AMREX_GPU_DEVICE (long ip) {
+                        amrex::ParticleReal xp, yp, zp;
+                        int pid;
+                        getPosition(ip, xp, yp, zp, pid);
+                        if (pid < 0) return;
+                        amrex::ParticleReal ExmByp = 0., EypBxp = 0., Ezp = 0.;
+                        amrex::ParticleReal Bxp = 0., Byp = 0., Bzp = 0.;
+                        doGatherShapeN<depos_order_xy, 0>(xp, yp, zmin, ExmByp, EypBxp, Ezp,
+                            Bxp, Byp, Bzp, exmby, eypbx, ez, bx, by, bz, dx_arr, xyzmin_arr, lo);
+                        p_sink[ip] = ExmByp + EypBxp + Ezp + Bxp + Byp + Bzp;
+                    });
+            }
+        });
+    }
+}
+
+int main (int argc, char* argv[])
+{
+    amrex::Initialize(argc,argv);
+    HIPACE_PROFILE_VAR("main()", pmain);
+    {
+        AMREX_ALWAYS_ASSERT_WITH_MESSAGE(amrex::ParallelDescriptor::NProcs() == 1,
+                                         "The kernel benchmarks run on a single rank");
+
+        int repetitions = 10;
+        amrex::Vector<int> poisson_n_cell {64, 128, 256, 512};
+        amrex::ParmParse ppb("benchmark");
+        ppb.query("repetitions", repetitions);
+        ppb.queryarr("poisson_n_cell", poisson_n_cell);
+        AMREX_ALWAYS_ASSERT_WITH_MESSAGE(repetitions > 0, "benchmark.repetitions must be > 0");
+
+        // The slices get enough guard cells for the highest deposition order
+        amrex::ParmParse pph("hipace");
+        if (!pph.contains("depos_order_xy")) pph.add("depos_order_xy", 3);
+
+        Hipace hipace;
+        hipace.InitData();
+        constexpr int lev = 0;
+        const amrex::Geometry& geom = hipace.Geom(lev);
+        MultiPlasma& plasmas = hipace.m_multi_plasma;
+        MultiBeam& beams = hipace.m_multi_beam;
+        Fields& fields = hipace.m_fields;
+        const int max_order = Hipace::m_depos_order_xy;
+
+        amrex::Print() << std::left << std::setw(32) << "kernel" << std::setw(20) << "config"
+                       << std::right << std::setw(14) << "time/call [s]" << std::setw(14)
+                       << "throughput" << "\n";
+
+        // Plasma kernels, on the initial plasma slice
+        plasmas.ResetParticles(lev, true);
+        for (int ip = 0; ip < plasmas.get_nplasmas(); ++ip) {
+            PlasmaParticleContainer& plasma = plasmas.getPlasma(ip);
+            const double np = plasma.TotalNumberOfParticles(false, true);
+            const std::string name = plasma.get_name();
+
+            for (int order = 0; order <= max_order; ++order) {
+                Hipace::m_depos_order_xy = order;
+                const double t = TimeKernel(repetitions, [&] () {
+                    DepositCurrent(plasma, fields, WhichSlice::This, false, true, true, true,
+                                   false, geom, lev);
+                });
+                Report("plasma doDepositionShapeN", name + " order " + std::to_string(order),
+                       t, np, "particles/s");
+            }
+            Hipace::m_depos_order_xy = max_order;
+
+            double t = TimeGather<0>(plasma, fields, geom, repetitions);
+            Report("plasma doGatherShapeN", name + " order 0", t, np, "particles/s");
+            if (max_order >= 1) {
+                t = TimeGather<1>(plasma, fields, geom, repetitions);
+                Report("plasma doGatherShapeN", name + " order 1", t, np, "particles/s");
+            }
+            if (max_order >= 2) {
+                t = TimeGather<2>(plasma, fields, geom, repetitions);
+                Report("plasma doGatherShapeN", name + " order 2", t, np, "particles/s");
+            }
+            if (max_order >= 3) {
+                t = TimeGather<3>(plasma, fields, geom, repetitions);
+                Report("plasma doGatherShapeN", name + " order 3", t, np, "particles/s");
+            }
+
+            // gather, force terms update and PlasmaParticlePush
+            t = TimeKernel(repetitions, [&] () {
+                AdvancePlasmaParticles(plasma, fields, geom, false, true, true, true, lev);
+            });
+            Report("plasma PlasmaParticlePush", name, t, np, "particles/s");
+        }
+        plasmas.ResetParticles(lev, true);
+
+        // Beam kernels, over all boxes
+        const amrex::BoxArray& ba = hipace.boxArray(lev);
+        for (int ibeam = 0; ibeam < beams.get_nbeams(); ++ibeam) {
+            BeamParticleContainer& beam = beams.getBeam(ibeam);
+            const double np = beam.numParticles();
+            const std::string name = beam.get_name();
+            BoxSorter sorter;
+
+            double t = TimeKernel(repetitions, [&] () {
+                sorter.sortParticlesByBox(beam, ba, geom);
+            });
+            Report("BoxSorter::sortParticlesByBox", name, t, np, "particles/s");
+
+            amrex::Vector<BeamBins> bins(ba.size());
+            t = TimeKernel(repetitions, [&] () {
+                for (int it = ba.size()-1; it >= 0; --it) {
+                    bins[it] = findParticlesInEachSlice(lev, it, ba[it], beam, geom, sorter);
+                }
+            });
+            Report("findParticlesInEachSlice", name, t, np, "particles/s");
+
+            t = TimeKernel(repetitions, [&] () {
+                for (int it = ba.size()-1; it >= 0; --it) {
+                    const amrex::Box& bx = ba[it];
+                    const int offset = sorter.boxOffsetsPtr()[it];
+                    for (int isl = bx.bigEnd(Direction::z); isl >= bx.smallEnd(Direction::z);
+                         --isl) {
+                        AdvanceBeamParticlesSlice(beam, fields, geom, lev, isl, bx, offset,
+                                                  bins[it]);
+                    }
+                }
+            });
+            Report("beam AdvanceBeamParticlesSlice", name, t, np, "particles/s");
+        }
+
+        // Transverse Poisson solver, on single slices of various sizes
+        for (const int n : poisson_n_cell) {
+            const amrex::Box domain({0, 0, 0}, {n-1, n-1, 0});
+            const amrex::BoxArray slice_ba(domain);
+            const amrex::DistributionMapping slice_dm(slice_ba);
+            const amrex::RealBox slice_rb({geom.ProbLo(0), geom.ProbLo(1), 0.},
+                                          {geom.ProbHi(0), geom.ProbHi(1), 1.});
+            const amrex::Array<int, AMREX_SPACEDIM> is_periodic {0, 0, 0};
+            const amrex::Geometry slice_geom(domain, &slice_rb, amrex::CoordSys::cartesian,
+                                             is_periodic.data());
+
+            FFTPoissonSolverDirichlet solver(slice_ba, slice_dm, slice_geom);
+            amrex::MultiFab lhs(slice_ba, slice_dm, 1, 0);
+            const double t = TimeKernel(repetitions, [&] () {
+                solver.StagingArea().setVal(1.);
+                solver.SolvePoissonEquation(lhs);
+            });
+            Report("FFTPoissonSolverDirichlet", std::to_string(n) + "x" + std::to_string(n), t,
+                   static_cast<double>(n)*n, "cells/s");
+        }
+    }
+    HipaceTracer::WriteTrace();
+    HIPACE_PROFILE_VAR_STOP(pmain);
+    amrex::Finalize();
+}
@@ -28,6 +28,11 @@ parser.add_argument('--beam-out2',
                     dest='beam_out2',
                     default='',
                     help='Path to the data of the restart run')
+parser.add_argument('--iteration',
+                    dest='iteration',
+                    type=int,
+                    default=0,
+                    help='Iteration of the two hipace runs to compare')
 parser.add_argument('--SI',
                     dest='in_SI_units',
                     action='store_true',
@@ -48,8 +53,8 @@ if args.beam_py != '' and args.beam_out1 != '' and args.beam_out2 == '':
 elif args.beam_py == '' and args.beam_out1 != '' and args.beam_out2 != '':
     beam_ser[0] = io.Series(args.beam_out1,io.Access.read_only)
     beam_ser[1] = io.Series(args.beam_out2,io.Access.read_only)
-    beam_par[0] = beam_ser[0].iterations[0].particles["beam"]
-    beam_par[1] = beam_ser[1].iterations[0].particles["beam"]
+    beam_par[0] = beam_ser[0].iterations[args.iteration].particles["beam"]
+    beam_par[1] = beam_ser[1].iterations[args.iteration].particles["beam"]
     beam_type = [1, 1]
 
 else:
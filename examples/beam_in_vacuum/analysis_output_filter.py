@@ -0,0 +1,55 @@
+#! /usr/bin/env python3
+
+# This Python analysis script is part of the code HiPACE++
+#
+# It compares the beam written with output filters to the full beam of a reference run, and
+# asserts that exactly the particles passing the z window and the id stride are candidates, that
+# the written particles are a subset of them with unchanged data, and that the written fraction
+# matches output_fraction.
+
+import numpy as np
+import argparse
+from openpmd_viewer import OpenPMDTimeSeries
+
+parser = argparse.ArgumentParser(description='Script to analyze the beam output filters')
+parser.add_argument('--reference', dest='reference', required=True,
+                    help='Path to the output of the run without filters')
+parser.add_argument('--filtered', dest='filtered', required=True,
+                    help='Path to the output of the run with filters')
+parser.add_argument('--zmin', dest='zmin', type=float, required=True)
+parser.add_argument('--zmax', dest='zmax', type=float, required=True)
+parser.add_argument('--id-stride', dest='id_stride', type=int, required=True)
+parser.add_argument('--fraction', dest='fraction', type=float, required=True)
+args = parser.parse_args()
+
+ts_ref = OpenPMDTimeSeries(args.reference)
+ts_fil = OpenPMDTimeSeries(args.filtered)
+
+for iteration in ts_ref.iterations:
+    id_ref, x_ref, z_ref, uz_ref = ts_ref.get_particle(species='beam', iteration=iteration,
+                                                       var_list=['id', 'x', 'z', 'uz'])
+    id_fil, x_fil, z_fil, uz_fil = ts_fil.get_particle(species='beam', iteration=iteration,
+                                                       var_list=['id', 'x', 'z', 'uz'])
+
+    # candidates: particles of the reference run passing the z window and the id stride
+    candidates = (z_ref >= args.zmin) & (z_ref <= args.zmax) & (id_ref % args.id_stride == 0)
+    n_candidates = np.sum(candidates)
+    print("iteration " + str(iteration) + ": " + str(len(id_ref)) + " particles, " +
+          str(n_candidates) + " candidates, " + str(len(id_fil)) + " written")
+    assert(n_candidates > 100)
+
+    # the written particles are candidates, and their data is unchanged
+    order_ref = np.argsort(id_ref)
+    index = order_ref[np.searchsorted(id_ref, id_fil, sorter=order_ref)]
+    assert(np.all(id_ref[index] == id_fil))
+    assert(np.all(candidates[index]))
+    assert(np.array_equal(x_ref[index], x_fil))
+    assert(np.array_equal(z_ref[index], z_fil))
+    assert(np.array_equal(uz_ref[index], uz_fil))
+
+    # the written fraction of the candidates is output_fraction, within 5 standard deviations
+    ratio = len(id_fil) / n_candidates
+    tolerance = 5. * np.sqrt(args.fraction * (1. - args.fraction) / n_candidates)
+    print("written fraction: " + str(ratio) + " (expected " + str(args.fraction) +
+          ", tolerance " + str(tolerance) + ")")
+    assert(abs(ratio - args.fraction) < tolerance)
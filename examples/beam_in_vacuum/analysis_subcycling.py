@@ -0,0 +1,41 @@
+#! /usr/bin/env python3
+
+# This Python analysis script is part of the code HiPACE++
+#
+# It is used in the adaptive_subcycling test and compares the beam of a run with uniform
+# sub-cycling with the beam of a run with adaptive sub-cycling.
+
+import argparse
+import numpy as np
+from openpmd_viewer import OpenPMDTimeSeries
+
+parser = argparse.ArgumentParser(
+    description='Script to compare uniform and adaptive sub-cycling of the beam pusher')
+parser.add_argument('--uniform-dir',
+                    dest='uniform_dir',
+                    required=True,
+                    help='Path to the output of the run with uniform sub-cycling')
+parser.add_argument('--adaptive-dir',
+                    dest='adaptive_dir',
+                    required=True,
+                    help='Path to the output of the run with adaptive sub-cycling')
+args = parser.parse_args()
+
+def beam_moments(output_dir):
+    ts = OpenPMDTimeSeries(output_dir)
+    xp, yp, uxp, uzp, wp = ts.get_particle(species='beam', iteration=ts.iterations[-1],
+                                           var_list=['x', 'y', 'ux', 'uz', 'w'])
+    std_x = np.sqrt(np.sum(xp**2*wp)/np.sum(wp))
+    std_y = np.sqrt(np.sum(yp**2*wp)/np.sum(wp))
+    std_ux = np.sqrt(np.sum(uxp**2*wp)/np.sum(wp))
+    mean_uz = np.sum(uzp*wp)/np.sum(wp)
+    return np.array([std_x, std_y, std_ux, mean_uz])
+
+moments_uniform = beam_moments(args.uniform_dir)
+moments_adaptive = beam_moments(args.adaptive_dir)
+
+print("std_x std_y std_ux mean_uz uniform : " + str(moments_uniform))
+print("std_x std_y std_ux mean_uz adaptive: " + str(moments_adaptive))
+
+# Assert sub-percent difference
+assert(np.all(np.abs(moments_adaptive-moments_uniform) < 1.e-2*np.abs(moments_uniform)))
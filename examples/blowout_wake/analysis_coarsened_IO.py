@@ -0,0 +1,30 @@
+#! /usr/bin/env python3
+
+# This Python analysis script is part of the code Hipace
+#
+# It compares a field from a simulation with full IO and from a simulation with coarsened IO
+
+import numpy as np
+from openpmd_viewer import OpenPMDTimeSeries
+
+field = 'Bz'
+cr = (2, 2, 2)
+
+ts1 = OpenPMDTimeSeries('full_io')
+F_full = ts1.get_field(field=field, iteration=ts1.iterations[-1])[0]
+F_full = np.swapaxes(F_full,0,2)
+nx, ny, nz = F_full.shape
+F_full_avg = F_full.reshape(nx//cr[0], cr[0], ny//cr[1], cr[1], nz//cr[2], cr[2]).mean(
+    axis=(1,3,5))
+
+ts2 = OpenPMDTimeSeries('coarse_io')
+F_coarse = ts2.get_field(field=field, iteration=ts2.iterations[-1])[0]
+F_coarse = np.swapaxes(F_coarse,0,2)
+
+error = np.max(np.abs(F_coarse-F_full_avg)) / np.max(np.abs(F_full_avg))
+
+print("F_full.shape", F_full.shape)
+print("F_coarse.shape", F_coarse.shape)
+print("error", error)
+
+assert(error < 1.e-12)
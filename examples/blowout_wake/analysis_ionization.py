@@ -0,0 +1,42 @@
+#! /usr/bin/env python3
+
+# This Python analysis script is part of the code HiPACE++
+#
+# It compares the number of electrons created by ionization in two runs that only differ by the
+# way the ionization rate is evaluated, and asserts that they agree within the statistical
+# fluctuations of the random ionization events.
+
+import argparse
+import numpy as np
+from openpmd_viewer import OpenPMDTimeSeries
+
+parser = argparse.ArgumentParser(
+    description='Script to compare the number of ionized electrons of two runs')
+parser.add_argument('--reference',
+                    dest='reference',
+                    required=True,
+                    help='Path to the output of the reference run')
+parser.add_argument('--output',
+                    dest='output',
+                    required=True,
+                    help='Path to the output of the run to compare')
+parser.add_argument('--species',
+                    dest='species',
+                    default='elec',
+                    help='Name of the ionization product')
+args = parser.parse_args()
+
+ts_ref = OpenPMDTimeSeries(args.reference)
+ts_out = OpenPMDTimeSeries(args.output)
+
+for iteration in ts_ref.iterations:
+    w_ref, = ts_ref.get_particle(species=args.species, iteration=iteration, var_list=['w'])
+    w_out, = ts_out.get_particle(species=args.species, iteration=iteration, var_list=['w'])
+    n_ref = len(w_ref)
+    n_out = len(w_out)
+    # both counts fluctuate independently, with at most a Poisson variance each
+    tolerance = 5. * np.sqrt(n_ref + n_out)
+    print("iteration " + str(iteration) + ": " + str(n_ref) + " electrons in the reference, " +
+          str(n_out) + " in the output, tolerance " + str(tolerance))
+    assert(n_ref > 100)
+    assert(abs(n_out - n_ref) < tolerance)
@@ -0,0 +1,64 @@
+#! /usr/bin/env python3
+
+# This Python analysis script is part of the code HiPACE++
+#
+# It compares the in-situ reduced diagnostics (per-slice beam moments and on-axis field
+# lineouts) with the same quantities computed from the full output.
+
+import argparse
+import numpy as np
+from openpmd_viewer import OpenPMDTimeSeries
+
+parser = argparse.ArgumentParser(
+    description='Script to compare the reduced diagnostics with the full output')
+parser.add_argument('--output-dir',
+                    dest='output_dir',
+                    required=True,
+                    help='Path to the full output')
+parser.add_argument('--reduced-dir',
+                    dest='reduced_dir',
+                    required=True,
+                    help='Path to the reduced diagnostics')
+args = parser.parse_args()
+
+ts = OpenPMDTimeSeries(args.output_dir)
+iteration = ts.iterations[-1]
+
+# columns: z Ez ExmBy beam_charge beam_x_mean beam_y_mean beam_x_std ...
+data = np.loadtxt(args.reduced_dir + '/reduced_%06d.txt' % iteration)
+data = data[np.argsort(data[:,0])]
+z_slice = data[:,0]
+Ez_reduced = data[:,1]
+charge_reduced = np.abs(data[:,3])
+x_std_reduced = data[:,6]
+
+# per-slice charge and rms size from the full beam output
+xp, zp, wp = ts.get_particle(species='beam', iteration=iteration, var_list=['x', 'z', 'w'])
+dz = z_slice[1] - z_slice[0]
+zlo = z_slice[0] - 0.5*dz
+islice = np.floor((zp - zlo)/dz).astype(int)
+nslices = z_slice.size
+sw = np.bincount(islice, weights=wp, minlength=nslices)
+swx = np.bincount(islice, weights=wp*xp, minlength=nslices)
+swxx = np.bincount(islice, weights=wp*xp**2, minlength=nslices)
+has_beam = sw > 0
+x_std_full = np.sqrt(np.maximum(swxx[has_beam]/sw[has_beam] - (swx[has_beam]/sw[has_beam])**2,
+                                0.))
+
+# on-axis Ez from the full field output, averaged over the cells around the axis
+F = ts.get_field(field='Ez', iteration=iteration)[0]
+F = np.swapaxes(F,0,2)
+nx, ny, nz = F.shape
+Ez_full = F[nx//2-1:nx//2+1, ny//2-1:ny//2+1, :].mean(axis=(0,1))
+
+error_charge = np.max(np.abs(charge_reduced - sw)) / np.max(sw)
+error_x_std = np.max(np.abs(x_std_reduced[has_beam] - x_std_full)) / np.max(x_std_full)
+error_Ez = np.max(np.abs(Ez_reduced - Ez_full)) / np.max(np.abs(Ez_full))
+
+print("error_charge", error_charge)
+print("error_x_std", error_x_std)
+print("error_Ez", error_Ez)
+
+assert(error_charge < 1.e-10)
+assert(error_x_std < 1.e-6)
+assert(error_Ez < 1.e-10)
@@ -1,5 +1,7 @@
 #include "Hipace.H"
 #include "utils/HipaceProfilerWrapper.H"
+#include "utils/HipaceTracer.H"
+#include "utils/BenchmarkMode.H"
 #include "particles/BinSort.H"
 #include "particles/BoxSort.H"
 #include "utils/IOUtil.H"
@@ -7,12 +9,15 @@
 
 #include <AMReX_ParmParse.H>
 #include <AMReX_IntVect.H>
+#include <AMReX_ParallelReduce.H>
 #ifdef AMREX_USE_LINEAR_SOLVERS
 #  include <AMReX_MLALaplacian.H>
 #  include <AMReX_MLMG.H>
 #endif
 
 #include <algorithm>
+#include <cmath>
+#include <limits>
 #include <memory>
 
 #ifdef AMREX_USE_MPI
@@ -83,7 +88,13 @@ Hipace::Hipace () :
     pph.query("numprocs_x", m_numprocs_x);
     pph.query("numprocs_y", m_numprocs_y);
     m_numprocs_z = amrex::ParallelDescriptor::NProcs() / (m_numprocs_x*m_numprocs_y);
-    AMREX_ALWAYS_ASSERT_WITH_MESSAGE(m_numprocs_z <= m_max_step+1,
+    if (m_checkpoint.isRestart()) {
+        m_start_step = m_checkpoint.restartStep();
+        AMREX_ALWAYS_ASSERT_WITH_MESSAGE(
+            m_checkpoint.restartNprocsXY() == m_numprocs_x*m_numprocs_y,
+            "Restarting from a checkpoint requires the same transverse parallelization");
+    }
+    AMREX_ALWAYS_ASSERT_WITH_MESSAGE(m_numprocs_z <= m_max_step-m_start_step+1,
                                      "Please use more or equal time steps than number of ranks");
     AMREX_ALWAYS_ASSERT_WITH_MESSAGE(m_numprocs_x*m_numprocs_y*m_numprocs_z
                                      == amrex::ParallelDescriptor::NProcs(),
@@ -102,6 +113,8 @@ Hipace::Hipace () :
     pph.query("beam_injection_cr", m_beam_injection_cr);
     pph.query("do_beam_jx_jy_deposition", m_do_beam_jx_jy_deposition);
     pph.query("do_device_synchronize", m_do_device_synchronize);
+    pph.query("report_throughput", m_throughput.m_report);
+    pph.query("benchmark_mode", m_benchmark_mode);
     pph.query("external_ExmBy_slope", m_external_ExmBy_slope);
     pph.query("external_Ez_slope", m_external_Ez_slope);
     pph.query("external_Ez_uniform", m_external_Ez_uniform);
@@ -116,6 +129,13 @@ Hipace::Hipace () :
         !(m_explicit && !m_multi_plasma.AllSpeciesNeutralizeBackground()),
         "Ion motion with explicit solver is not implemented, need to use neutralize_background");
 
+    pph.query("skip_unperturbed_slices", m_skip_unperturbed_slices);
+    pph.query("use_active_region", m_use_active_region);
+    pph.query("active_region_margin", m_active_region_margin);
+    pph.query("active_region_threshold", m_active_region_threshold);
+    AMREX_ALWAYS_ASSERT_WITH_MESSAGE(!(m_use_active_region && m_grid_current.isActive()),
+        "hipace.use_active_region cannot be used with a grid current, which covers the full slice");
+    if (m_use_active_region) m_multi_plasma.TrackDisturbedExtent(m_active_region_threshold);
     pph.query("MG_tolerance_rel", m_MG_tolerance_rel);
     pph.query("MG_tolerance_abs", m_MG_tolerance_abs);
 
@@ -138,6 +158,12 @@ Hipace::Hipace () :
     MPI_Comm_rank(m_comm_xy, &m_rank_xy);
     MPI_Comm_split(amrex::ParallelDescriptor::Communicator(), m_rank_xy, myproc, &m_comm_z);
 #endif
+
+    std::string trace_file = "";
+    int trace_max_events = 1000000;
+    pph.query("trace_file", trace_file);
+    pph.query("trace_max_events", trace_max_events);
+    if (!trace_file.empty()) HipaceTracer::Enable(trace_file, m_rank_z, trace_max_events);
 }
 
 Hipace::~Hipace ()
@@ -235,13 +261,26 @@ Hipace::InitData ()
 
     AmrCore::InitFromScratch(0.0); // function argument is time
     constexpr int lev = 0;
-    m_multi_beam.InitData(geom[lev]);
+    if (m_checkpoint.isRestart()) {
+        // The whole beam goes to the head rank, as for a regular initialization
+        const bool is_head = m_rank_z == m_numprocs_z-1;
+        m_checkpoint.ReadBeams(m_multi_beam, is_head, m_rank_xy);
+        if (is_head) m_checkpoint.ReadRandomState(m_rank_xy);
+    } else {
+        m_multi_beam.InitData(geom[lev]);
+    }
     m_multi_plasma.InitData(m_slice_ba, m_slice_dm, m_slice_geom, geom);
-    m_adaptive_time_step.Calculate(m_dt, m_multi_beam, m_multi_plasma.maxDensity());
+    if (m_checkpoint.isRestart()) {
+        m_physical_time = m_checkpoint.restartTime();
+        m_dt = m_checkpoint.restartDt();
+    } else {
+        m_adaptive_time_step.Calculate(m_dt, m_multi_beam, m_multi_plasma.maxDensity());
 #ifdef AMREX_USE_MPI
-    m_adaptive_time_step.WaitTimeStep(m_dt, m_comm_z);
-    m_adaptive_time_step.NotifyTimeStep(m_dt, m_comm_z);
+        m_adaptive_time_step.WaitTimeStep(m_dt, m_comm_z);
+        m_adaptive_time_step.NotifyTimeStep(m_dt, m_comm_z);
 #endif
+    }
+    if (m_verbose >= 1) ReportMemory("Memory usage after initialization", true);
 }
 
 void
@@ -351,6 +390,7 @@ void
 Hipace::Evolve ()
 {
     HIPACE_PROFILE("Hipace::Evolve()");
+    const double evolve_start = amrex::second();
     const int rank = amrex::ParallelDescriptor::MyProc();
     int const lev = 0;
 
@@ -358,7 +398,8 @@ Hipace::Evolve ()
     m_multi_beam.sortParticlesByBox(m_box_sorters, boxArray(lev), geom[lev]);
 
     // now each rank starts with its own time step and writes to its own file. Highest rank starts with step 0
-    for (int step = m_numprocs_z - 1 - m_rank_z; step <= m_max_step; step += m_numprocs_z)
+    for (int step = m_start_step + m_numprocs_z - 1 - m_rank_z; step <= m_max_step;
+         step += m_numprocs_z)
     {
 #ifdef HIPACE_USE_OPENPMD
         m_openpmd_writer.InitDiagnostics(step, m_output_period, m_max_step, finestLevel()+1);
@@ -369,22 +410,32 @@ Hipace::Evolve ()
         ResetAllQuantities();
 
         /* Store charge density of (immobile) ions into WhichSlice::RhoIons */
-        m_multi_plasma.DepositNeutralizingBackground(m_fields, WhichSlice::RhoIons, geom[lev],
-                                                     finestLevel()+1);
+        if (!m_rho_ions_deposited) {
+            m_multi_plasma.DepositNeutralizingBackground(m_fields, WhichSlice::RhoIons,
+                                                         geom[lev], finestLevel()+1);
+            m_rho_ions_deposited = true;
+        }
+
+        m_reduced_diags.InitStep(step, m_max_step, m_multi_beam.get_nbeams(), geom[lev]);
 
         // Loop over longitudinal boxes on this rank, from head to tail
         const int n_boxes = (m_boxes_in_z == 1) ? m_numprocs_z : m_boxes_in_z;
         for (int it = n_boxes-1; it >= 0; --it)
         {
-            Wait(step, it);
-
-            m_box_sorters.clear();
+            TimedWait(step, it);
+            // the beam is largest when the particles of the upstream rank were just received
+            if (m_verbose >= 1) RecordMemory();
 
             m_multi_beam.sortParticlesByBox(m_box_sorters, boxArray(lev), geom[lev]);
             m_leftmost_box_snd = std::min(leftmostBoxWithParticles(), m_leftmost_box_snd);
 
             WriteDiagnostics(step, it, OpenPMDWriterCallType::beams);
 
+            if (m_checkpoint.doCheckpoint(step, m_start_step)) {
+                m_checkpoint.WriteBeams(m_multi_beam, step, it, n_boxes, m_box_sorters,
+                                        m_physical_time, m_dt, m_rank_xy);
+            }
+
             m_multi_beam.StoreNRealParticles();
             // Copy particles in box it-1 in the ghost buffer.
             // This handles both beam initialization and particle slippage.
@@ -406,7 +457,7 @@ Hipace::Evolve ()
                 SolveOneSlice(isl, it, bins);
             };
             // Receive ghost slice
-            if (it>0) Wait(step, it, true);
+            if (it>0) TimedWait(step, it, true);
             CheckGhostSlice(it);
             // Solve tail slice. Consume ghost particles.
             SolveOneSlice(bx.smallEnd(Direction::z), it, bins);
@@ -432,12 +483,35 @@ Hipace::Evolve ()
         m_predcorr_avg_iterations = 0.;
         m_predcorr_avg_B_error = 0.;
 
+        m_reduced_diags.WriteStep(m_multi_beam, geom[lev], m_physical_time, m_comm_xy,
+                                  m_rank_xy);
+
+        if (m_verbose >= 1) ReportMemory("Rank " + std::to_string(rank) +
+                                         ": memory usage at the end of step " +
+                                         std::to_string(step), false);
+
         m_physical_time += m_dt;
     }
 
 #ifdef HIPACE_USE_OPENPMD
     if (m_output_period > 0) m_openpmd_writer.reset();
 #endif
+
+    m_throughput.m_evolve_time = amrex::second() - evolve_start;
+    amrex::Vector<long> poisson_solves;
+    amrex::Vector<std::string> poisson_sizes;
+    for (int ilev = 0; ilev <= finestLevel(); ++ilev) {
+        poisson_solves.push_back(m_fields.m_poisson_solver[ilev]->NumSolves());
+        const amrex::Box slice_box = m_fields.m_poisson_solver[ilev]->StagingArea().boxArray()[0];
+        poisson_sizes.push_back(std::to_string(slice_box.length(0)) + "x" +
+                                std::to_string(slice_box.length(1)));
+    }
+    m_throughput.Report(m_multi_plasma.get_num_particle_pushes(),
+                        m_multi_beam.get_num_particle_pushes(), poisson_solves, poisson_sizes);
+    if (m_benchmark_mode) {
+        BenchmarkMode::Report(m_throughput.m_evolve_time, m_max_step - m_start_step + 1,
+                              geom[0].Domain(), m_numprocs_z);
+    }
 }
 
 void
@@ -445,6 +519,25 @@ Hipace::SolveOneSlice (int islice, const int ibox, amrex::Vector<BeamBins>& bins
 {
     HIPACE_PROFILE("Hipace::SolveOneSlice()");
 
+    // Ahead of the beam, the plasma is still at its initial position with zero momentum and all
+    // fields are zero, so the plasma push, deposition and field solve can be skipped.
+    if (m_ahead_of_beam) {
+        const int islice_local = islice - boxArray(0)[ibox].smallEnd(2);
+        int np = m_multi_beam.NumParticlesInSlice(bins, islice_local);
+        // the beam particles of the next slice deposit their current to Next, which enters the
+        // Bx and By solve of this slice. On the tail slice of a box, these are the ghost
+        // particles of the next box
+        if (islice_local > 0) {
+            np += m_multi_beam.NumParticlesInSlice(bins, islice_local-1);
+        } else {
+            for (int ibeam = 0; ibeam < m_multi_beam.get_nbeams(); ++ibeam) {
+                np += m_multi_beam.getBeam(ibeam).numParticles()
+                      - m_multi_beam.getNRealParticles(ibeam);
+            }
+        }
+        if (np > 0) m_ahead_of_beam = false;
+    }
+
     for (int lev = 0; lev <= finestLevel(); ++lev) {
 
         if (lev == 1) { // skip all slices which are not existing on level 1
@@ -465,6 +558,13 @@ Hipace::SolveOneSlice (int islice, const int ibox, amrex::Vector<BeamBins>& bins
         // particles on level 0. This must be addressed if we want to have longitudinal refinement.
         const int islice_local = islice - boxArray(0)[ibox].smallEnd(2);
 
+        if (m_ahead_of_beam) {
+            FillDiagnostics(lev, islice);
+            m_fields.ShiftSlices(lev);
+            amrex::ParallelContext::pop();
+            continue;
+        }
+
         if (m_explicit) {
             // Set all quantities to 0 except Bx and By: the previous slice serves as initial guess.
             const int ibx = Comps[WhichSlice::This]["Bx"];
@@ -480,6 +580,12 @@ Hipace::SolveOneSlice (int islice, const int ibox, amrex::Vector<BeamBins>& bins
         if (!m_explicit) m_multi_plasma.AdvanceParticles(m_fields, geom[lev], false,
                                                          true, false, false, lev);
 
+        // The plasma push above (or the explicit push of the previous slice) finds the
+        // disturbed plasma particles
+        if (m_use_active_region) UpdateActiveRegion(lev, islice_local, ibox, bins);
+        // The sources are only read inside the active region: no need to fill their guard cells
+        const bool fill_source_guards = m_explicit || !m_fields.ActiveRegionIsInterior(lev);
+
         amrex::MultiFab rho(m_fields.getSlices(lev, WhichSlice::This), amrex::make_alias,
                             Comps[WhichSlice::This]["rho"], 1);
 
@@ -515,7 +621,7 @@ Hipace::SolveOneSlice (int islice, const int ibox, amrex::Vector<BeamBins>& bins
                              ijz == ijx+4 && ijz_beam == ijx+5 && irho == ijx+6 );
         amrex::MultiFab j_slice(m_fields.getSlices(lev, WhichSlice::This),
                                 amrex::make_alias, Comps[WhichSlice::This]["jx"], 7);
-        j_slice.FillBoundary(Geom(lev).periodicity());
+        if (fill_source_guards) j_slice.FillBoundary(Geom(lev).periodicity());
 
         m_fields.SolvePoissonExmByAndEypBx(Geom(), m_comm_xy, lev);
 
@@ -524,7 +630,7 @@ Hipace::SolveOneSlice (int islice, const int ibox, amrex::Vector<BeamBins>& bins
                                          ibox, m_do_beam_jx_jy_deposition, WhichSlice::This);
         m_fields.AddBeamCurrents(lev, WhichSlice::This);
 
-        j_slice.FillBoundary(Geom(lev).periodicity());
+        if (fill_source_guards) j_slice.FillBoundary(Geom(lev).periodicity());
 
         m_fields.SolvePoissonEz(Geom(), lev);
         m_fields.SolvePoissonBz(Geom(), lev);
@@ -539,6 +645,12 @@ Hipace::SolveOneSlice (int islice, const int ibox, amrex::Vector<BeamBins>& bins
             PredictorCorrectorLoopToSolveBxBy(islice, lev, bx, bins, ibox);
         }
 
+        // Reduced diagnostics use the beam before it is pushed, consistent with the fields
+        if (lev == 0) {
+            m_reduced_diags.AccumulateSlice(m_multi_beam, m_fields, geom[lev], islice, bx, bins,
+                                            m_box_sorters, ibox);
+        }
+
         // Push beam particles
         m_multi_beam.AdvanceBeamParticlesSlice(m_fields, geom[lev], lev, islice, bx, bins,
                                                m_box_sorters, ibox);
@@ -559,14 +671,63 @@ Hipace::ResetAllQuantities ()
 {
     HIPACE_PROFILE("Hipace::ResetAllQuantities()");
 
+    // A neutral plasma at rest has no fields until the first slice with beam particles
+    m_ahead_of_beam = m_skip_unperturbed_slices && m_multi_plasma.IsNeutralAtRest()
+                      && !m_grid_current.isActive();
+
+    // The active region starts empty and grows along the step
+    constexpr amrex::Real huge = std::numeric_limits<amrex::Real>::max();
+    m_active_extent = amrex::RealBox({AMREX_D_DECL(huge, huge, huge)},
+                                     {AMREX_D_DECL(-huge, -huge, -huge)});
+
     for (int lev = 0; lev <= finestLevel(); ++lev) {
         m_multi_plasma.ResetParticles(lev, true);
         for (int islice=0; islice<WhichSlice::N; islice++) {
+            // the ion background is kept from one step to the next
+            if (islice == WhichSlice::RhoIons && m_rho_ions_deposited) continue;
             m_fields.getSlices(lev, islice).setVal(0.);
         }
     }
 }
 
+void
+Hipace::UpdateActiveRegion (const int lev, const int islice_local, const int ibox,
+                            amrex::Vector<BeamBins>& bins)
+{
+    HIPACE_PROFILE("Hipace::UpdateActiveRegion()");
+
+    // beam particles are binned on level 0 only
+    if (lev == 0) m_multi_beam.ExtendSliceExtent(bins, islice_local, m_box_sorters, ibox,
+                                                 m_active_extent);
+    m_multi_plasma.ExtendDisturbedExtent(m_active_extent);
+    // the region is the same on all transverse ranks
+    for (int idim = 0; idim < Direction::z; ++idim) {
+        amrex::Real lo = m_active_extent.lo(idim);
+        amrex::Real hi = m_active_extent.hi(idim);
+        amrex::ParallelAllReduce::Min(lo, m_comm_xy);
+        amrex::ParallelAllReduce::Max(hi, m_comm_xy);
+        m_active_extent.setLo(idim, lo);
+        m_active_extent.setHi(idim, hi);
+    }
+
+    amrex::Box region; // empty
+    if (m_active_extent.lo(0) <= m_active_extent.hi(0)) {
+        // cells touched by the particle shapes, plus the margin
+        const int ngrow = m_active_region_margin + m_depos_order_xy + 1;
+        const amrex::Real* dx = Geom(lev).CellSize();
+        const amrex::Real* plo = Geom(lev).ProbLo();
+        amrex::IntVect lo(0), hi(0);
+        for (int idim = 0; idim < Direction::z; ++idim) {
+            lo[idim] = static_cast<int>(
+                std::floor((m_active_extent.lo(idim) - plo[idim])/dx[idim])) - ngrow;
+            hi[idim] = static_cast<int>(
+                std::floor((m_active_extent.hi(idim) - plo[idim])/dx[idim])) + ngrow;
+        }
+        region = amrex::Box(lo, hi);
+    }
+    m_fields.SetActiveRegion(lev, region);
+}
+
 void
 Hipace::ExplicitSolveBxBy (const int lev)
 {
@@ -805,7 +966,7 @@ Hipace::PredictorCorrectorLoopToSolveBxBy (const int islice, const int lev, cons
         m_fields.getSlices(lev, WhichSlice::Previous2),
         Comps[WhichSlice::Previous1]["Bx"], Comps[WhichSlice::Previous1]["By"],
         Comps[WhichSlice::Previous2]["Bx"], Comps[WhichSlice::Previous2]["By"],
-        Geom(lev));
+        Geom(lev), lev);
 
     /* Guess Bx and By */
     m_fields.InitialBfieldGuess(relative_Bfield_error, m_predcorr_B_error_tolerance, lev);
@@ -856,6 +1017,7 @@ Hipace::PredictorCorrectorLoopToSolveBxBy (const int islice, const int lev, cons
 
     /* Begin of predictor corrector loop  */
     int i_iter = 0;
+    ++m_throughput.m_predcorr_slices;
     /* resetting the initial B-field error for mixing between iterations */
     relative_Bfield_error = 1.0;
     while (( relative_Bfield_error > m_predcorr_B_error_tolerance )
@@ -863,6 +1025,7 @@ Hipace::PredictorCorrectorLoopToSolveBxBy (const int islice, const int lev, cons
     {
         i_iter++;
         m_predcorr_avg_iterations += 1.0;
+        ++m_throughput.m_predcorr_iterations;
 
         /* Push particles to the next slice */
         m_multi_plasma.AdvanceParticles(m_fields, geom[lev], true, true, false, false, lev);
@@ -879,7 +1042,9 @@ Hipace::PredictorCorrectorLoopToSolveBxBy (const int islice, const int lev, cons
         // need to exchange jx jy jx_beam jy_beam
         amrex::MultiFab j_slice_next(m_fields.getSlices(lev, WhichSlice::Next),
                                      amrex::make_alias, Comps[WhichSlice::Next]["jx"], 4);
-        j_slice_next.FillBoundary(Geom(lev).periodicity());
+        if (!m_fields.ActiveRegionIsInterior(lev)) {
+            j_slice_next.FillBoundary(Geom(lev).periodicity());
+        }
         amrex::ParallelContext::pop();
 
         /* Calculate Bx and By */
@@ -891,7 +1056,7 @@ Hipace::PredictorCorrectorLoopToSolveBxBy (const int islice, const int lev, cons
             m_fields.getSlices(lev, WhichSlice::This),
             Bx_iter, By_iter,
             Comps[WhichSlice::This]["Bx"], Comps[WhichSlice::This]["By"],
-            0, 0, Geom(lev));
+            0, 0, Geom(lev), lev);
 
         if (i_iter == 1) relative_Bfield_error_prev_iter = relative_Bfield_error;
 
@@ -943,13 +1108,22 @@ Hipace::PredictorCorrectorLoopToSolveBxBy (const int islice, const int lev, cons
                             " relative B field error: "<<relative_Bfield_error<< "\n";
 }
 
+void
+Hipace::TimedWait (const int step, int it, bool only_ghost)
+{
+    const double wait_start = amrex::second();
+    Wait(step, it, only_ghost);
+    m_throughput.m_wait_time += amrex::second() - wait_start;
+    ++m_throughput.m_num_waits;
+}
+
 void
 Hipace::Wait (const int step, int it, bool only_ghost)
 {
     HIPACE_PROFILE("Hipace::Wait()");
 
 #ifdef AMREX_USE_MPI
-    if (step == 0) return;
+    if (step == m_start_step) return;
 
     // Receive physical time
     if (it == m_numprocs_z - 1 && !only_ghost) {
@@ -990,6 +1164,7 @@ Hipace::Wait (const int step, int it, bool only_ghost)
         const amrex::Long psize = sizeof(BeamParticleContainer::SuperParticleType);
         const amrex::Long buffer_size = psize*np_total;
         auto recv_buffer = (char*)amrex::The_Pinned_Arena()->alloc(buffer_size);
+        RecordCommMemory(buffer_size);
 
         MPI_Status status;
         const int loc_pcomm_z_tag = only_ghost ? pcomm_z_tag_ghost : pcomm_z_tag;
@@ -1048,6 +1223,10 @@ Hipace::Wait (const int step, int it, bool only_ghost)
             } else
 #endif
             {
+                // particles are unpacked independently, so the loop is threaded on CPU
+#ifdef AMREX_USE_OMP
+#pragma omp parallel for
+#endif
                 for (int i = 0; i < np; ++i)
                 {
                     ptd.unpackParticleData(
@@ -1096,6 +1275,7 @@ Hipace::Notify (const int step, const int it,
         const amrex::Real t = m_physical_time + m_dt;
         MPI_Isend(&t, 1, amrex::ParallelDescriptor::Mpi_typemap<amrex::Real>::type(),
                   (m_rank_z-1+m_numprocs_z)%m_numprocs_z, tcomm_z_tag, m_comm_z, &m_tsend_request);
+        m_throughput.m_bytes_sent += sizeof(amrex::Real);
     }
 
     m_leftmost_box_snd = std::min(m_leftmost_box_snd, m_leftmost_box_rcv);
@@ -1124,6 +1304,7 @@ Hipace::Notify (const int step, const int it,
     MPI_Request* loc_nsend_request = only_ghost ? &m_nsend_request_ghost : &m_nsend_request;
     MPI_Isend(np_snd.dataPtr(), nint, amrex::ParallelDescriptor::Mpi_typemap<int>::type(),
               (m_rank_z-1+m_numprocs_z)%m_numprocs_z, loc_ncomm_z_tag, m_comm_z, loc_nsend_request);
+    m_throughput.m_bytes_sent += nint*sizeof(int);
 
     // Send beam particles. Currently only one tile.
     {
@@ -1133,6 +1314,8 @@ Hipace::Notify (const int step, const int it,
         const amrex::Long buffer_size = psize*np_total;
         char*& psend_buffer = only_ghost ? m_psend_buffer_ghost : m_psend_buffer;
         psend_buffer = (char*)amrex::The_Pinned_Arena()->alloc(buffer_size);
+        (only_ghost ? m_psend_buffer_ghost_size : m_psend_buffer_size) = buffer_size;
+        RecordCommMemory();
 
         int offset_beam = 0;
         for (int ibeam = 0; ibeam < nbeams; ibeam++){
@@ -1148,11 +1331,11 @@ Hipace::Notify (const int step, const int it,
             const auto p_comm_int = comm_int.data();
             const auto p_psend_buffer = psend_buffer + offset_beam*psize;
 
-            BeamBins::index_type* indices = nullptr;
+            BeamBins::index_type const * indices = nullptr;
             BeamBins::index_type const * offsets = 0;
             BeamBins::index_type cell_start = 0;
 
-            indices = bins[ibeam].permutationPtr();
+            indices = getBinPermutation(bins[ibeam], ptile);
             offsets = bins[ibeam].offsetsPtr();
 
             // The particles that are in the last slice (sent as ghost particles) are
@@ -1177,7 +1360,8 @@ Hipace::Notify (const int step, const int it,
                         const unsigned int m = threadIdx.x;
                         const unsigned int mend = amrex::min<unsigned int>(blockDim.x, np-blockDim.x*blockIdx.x);
                         if (i < np) {
-                            const int src_i = only_ghost ? indices[cell_start+i] : i;
+                            const int src_i = !only_ghost ? i :
+                                indices ? indices[cell_start+i] : cell_start+i;
                             ptd.packParticleData(shared, offset_box+src_i, m*psize, p_comm_real, p_comm_int);
                         }
 
@@ -1194,9 +1378,14 @@ Hipace::Notify (const int step, const int it,
             } else
 #endif
             {
+                // particles are packed independently, so the loop is threaded on CPU
+#ifdef AMREX_USE_OMP
+#pragma omp parallel for
+#endif
                 for (int i = 0; i < np; ++i)
                 {
-                    const int src_i = only_ghost ? indices[cell_start+i] : i;
+                    const int src_i = !only_ghost ? i :
+                        indices ? indices[cell_start+i] : cell_start+i;
                     ptd.packParticleData(p_psend_buffer, offset_box+src_i, i*psize, p_comm_real, p_comm_int);
                 }
             }
@@ -1212,6 +1401,7 @@ Hipace::Notify (const int step, const int it,
         // Each rank sends data downstream, except rank 0 who sends data to m_numprocs_z-1
         MPI_Isend(psend_buffer, buffer_size, amrex::ParallelDescriptor::Mpi_typemap<char>::type(),
                   (m_rank_z-1+m_numprocs_z)%m_numprocs_z, loc_pcomm_z_tag, m_comm_z, loc_psend_request);
+        m_throughput.m_bytes_sent += buffer_size;
     }
 #endif
 }
@@ -1231,6 +1421,7 @@ Hipace::NotifyFinish (const int it, bool only_ghost)
             MPI_Wait(&m_psend_request_ghost, &status);
             amrex::The_Pinned_Arena()->free(m_psend_buffer_ghost);
             m_psend_buffer_ghost = nullptr;
+            m_psend_buffer_ghost_size = 0;
         }
     } else {
         if (it == m_numprocs_z - 1) {
@@ -1248,6 +1439,7 @@ Hipace::NotifyFinish (const int it, bool only_ghost)
             MPI_Wait(&m_psend_request, &status);
             amrex::The_Pinned_Arena()->free(m_psend_buffer);
             m_psend_buffer = nullptr;
+            m_psend_buffer_size = 0;
         }
     }
 #endif
@@ -1270,11 +1462,58 @@ Hipace::ResizeFDiagFAB (const int it)
     }
 }
 
+void
+Hipace::RecordMemory ()
+{
+    const std::array<std::string, WhichSlice::N> slice_names
+        {"Next", "This", "Previous1", "Previous2", "RhoIons"};
+    for (int lev = 0; lev <= finestLevel(); ++lev) {
+        const std::string lev_str = " lev " + std::to_string(lev);
+        for (int islice = 0; islice < WhichSlice::N; ++islice) {
+            m_memory_report.Record("slice " + slice_names[islice] + lev_str,
+                                   MemoryReport::Bytes(m_fields.getSlices(lev, islice)));
+        }
+        m_memory_report.Record("FFT staging area" + lev_str,
+                               MemoryReport::Bytes(m_fields.m_poisson_solver[lev]->StagingArea()));
+        m_memory_report.Record("FFT spectral buffers" + lev_str,
+                               m_fields.m_poisson_solver[lev]->SpectralBytes());
+        m_memory_report.Record("diagnostics m_F" + lev_str, m_diags.getF(lev).nBytes());
+    }
+    for (int ip = 0; ip < m_multi_plasma.get_nplasmas(); ++ip) {
+        PlasmaParticleContainer& plasma = m_multi_plasma.getPlasma(ip);
+        amrex::Long bytes = 0;
+        for (const auto& particle_level : plasma.GetParticles()) {
+            for (const auto& kv : particle_level) bytes += MemoryReport::TileBytes(kv.second);
+        }
+        m_memory_report.Record("plasma " + plasma.get_name(), bytes);
+    }
+    // ghost particles are stored at the end of the beam arrays
+    for (int ibeam = 0; ibeam < m_multi_beam.get_nbeams(); ++ibeam) {
+        m_memory_report.Record("beam " + m_multi_beam.get_name(ibeam) + " (incl. ghosts)",
+                               MemoryReport::TileBytes(m_multi_beam.getBeam(ibeam)));
+    }
+    RecordCommMemory();
+}
+
+void
+Hipace::ReportMemory (const std::string& title, const bool reduce)
+{
+    RecordMemory();
+    m_memory_report.Print(title, reduce);
+}
+
+void
+Hipace::RecordCommMemory (const amrex::Long recv_size)
+{
+    m_memory_report.Record("pinned communication buffers",
+                           m_psend_buffer_size + m_psend_buffer_ghost_size + recv_size);
+}
+
 void
 Hipace::FillDiagnostics (const int lev, int i_slice)
 {
     m_fields.Copy(lev, i_slice, FieldCopyType::StoF, 0, 0, Comps[WhichSlice::This]["N"],
-                  m_diags.getF(lev), m_diags.sliceDir(), Geom(lev));
+                  m_diags.getF(lev), m_diags.sliceDir(), Geom(lev), m_diags.getCoarsening());
 }
 
 void
@@ -1353,18 +1592,19 @@ Hipace::CheckGhostSlice (int it)
 
         // Get pointers to ghost particles
         auto& ptile = m_multi_beam.getBeam(ibeam);
-        auto& aos = ptile.GetArrayOfStructs();
-        const auto& pos_structs = aos.begin() + nreal;
+        const auto getPosition = GetParticlePosition<BeamParticleContainer>(ptile, nreal);
+        const auto setPosition = SetParticlePosition<BeamParticleContainer>(ptile, nreal);
 
         // Invalidate particles out of the ghost slice
         amrex::ParallelFor(
             nghost,
             [=] AMREX_GPU_DEVICE (long idx) {
                 // Get zp of ghost particle
-                const amrex::Real zp = pos_structs[idx].pos(2);
+                amrex::ParticleReal xp, yp, zp;
+                getPosition(idx, xp, yp, zp);
                 // Invalidate ghost particle if not in the ghost slice
                 if ( zp < zmin_leftcell || zp > zmax_leftcell ) {
-                    pos_structs[idx].id() = -1;
+                    setPosition(idx, xp, yp, zp, -1);
                 }
             }
             );
@@ -0,0 +1,275 @@
+#include "Checkpoint.H"
+#include "Hipace.H"
+#include "utils/HipaceProfilerWrapper.H"
+
+#include <AMReX_OpenMP.H>
+#include <AMReX_ParmParse.H>
+#include <AMReX_ParallelDescriptor.H>
+#include <AMReX_ParallelReduce.H>
+#include <AMReX_Random.H>
+#include <AMReX_Utility.H>
+
+#include <iomanip>
+#include <limits>
+#include <sstream>
+
+namespace
+{
+    /** Version of the checkpoint format, written in the manifest */
+    const std::string checkpoint_version = "HiPACE++_checkpoint_1";
+
+    /** \brief Reads `key value` from the manifest and checks the key
+     * \param[in,out] is manifest stream
+     * \param[in] key expected key
+     * \param[out] value value read
+     */
+    template<typename T>
+    void ReadHeaderEntry (std::istream& is, const std::string& key, T& value)
+    {
+        std::string k;
+        is >> k >> value;
+        AMREX_ALWAYS_ASSERT_WITH_MESSAGE(is.good() && k == key,
+            "Invalid checkpoint header, expected entry " + key);
+    }
+
+    /** Name of the blob containing the particles of a beam written by a transverse rank */
+    std::string BeamFileName (const std::string& dir, const std::string& name, const int rank_xy)
+    {
+        return amrex::Concatenate(dir + "/" + name + ".", rank_xy, 5);
+    }
+}
+
+Checkpoint::Checkpoint ()
+{
+    amrex::ParmParse pph("hipace");
+    pph.query("checkpoint_period", m_period);
+    AMREX_ALWAYS_ASSERT_WITH_MESSAGE(m_period != 0,
+                                     "To avoid checkpoints, please use checkpoint_period = -1.");
+    pph.query("checkpoint_prefix", m_prefix);
+    pph.query("restart_from", m_restart_dir);
+    if (isRestart()) ReadHeader();
+}
+
+bool
+Checkpoint::doCheckpoint (const int step, const int start_step) const
+{
+    // The first step of a restarted run is the checkpoint it was restarted from
+    return m_period > 0 && step % m_period == 0 && step != start_step;
+}
+
+void
+Checkpoint::WriteBeams (MultiBeam& beams, const int step, const int it, const int n_boxes,
+                        const amrex::Vector<BoxSorter>& a_box_sorter_vec,
+                        const amrex::Real physical_time, const amrex::Real dt, const int rank_xy)
+{
+    HIPACE_PROFILE("Checkpoint::WriteBeams()");
+
+    using ParticleType = BeamParticleContainer::ParticleType;
+    const int nbeams = beams.get_nbeams();
+    const std::string dir = amrex::Concatenate(m_prefix + "/chk", step, 6);
+
+    // first box of this step: create the directory, save the random state before any box of
+    // this step draws random numbers, and open one blob per beam
+    if (it == n_boxes-1) {
+        if (!amrex::UtilCreateDirectory(dir, 0755)) amrex::CreateDirectoryFailed(dir);
+#ifndef AMREX_USE_GPU
+        const std::string rng_file = amrex::Concatenate(dir + "/rng.", rank_xy, 5);
+        std::ofstream rng_ofs(rng_file);
+        if (!rng_ofs.good()) amrex::FileOpenFailed(rng_file);
+        amrex::SaveRandomState(rng_ofs);
+#endif
+        m_beam_files.clear();
+        m_beam_files.resize(nbeams);
+        m_num_written.assign(nbeams, 0);
+        for (int ibeam = 0; ibeam < nbeams; ibeam++) {
+            const std::string filename = BeamFileName(dir, beams.get_name(ibeam), rank_xy);
+            m_beam_files[ibeam].open(filename, std::ios::out | std::ios::binary |
+                                               std::ios::trunc);
+            if (!m_beam_files[ibeam].good()) amrex::FileOpenFailed(filename);
+        }
+    }
+
+    // Each box is a chunk: number of particles, raw AoS, then each SoA component
+    amrex::Vector<ParticleType> aos_buf;
+    amrex::Vector<amrex::ParticleReal> soa_buf;
+    for (int ibeam = 0; ibeam < nbeams; ibeam++) {
+        auto& beam = beams.getBeam(ibeam);
+        auto& ofs = m_beam_files[ibeam];
+        const uint64_t box_offset = a_box_sorter_vec[ibeam].boxOffsetsPtr()[it];
+        const uint64_t np = a_box_sorter_vec[ibeam].boxCountsPtr()[it];
+        ofs.write(reinterpret_cast<const char*>(&np), sizeof(np));
+        if (np == 0) continue;
+
+        auto& aos = beam.GetArrayOfStructs()();
+        aos_buf.resize(np);
+        amrex::Gpu::copyAsync(amrex::Gpu::deviceToHost, aos.begin() + box_offset,
+                              aos.begin() + box_offset + np, aos_buf.begin());
+        amrex::Gpu::streamSynchronize();
+        ofs.write(reinterpret_cast<const char*>(aos_buf.dataPtr()), np*sizeof(ParticleType));
+
+        soa_buf.resize(np);
+        for (int comp=0; comp<BeamIdx::nattribs; ++comp) {
+            auto& rdata = beam.GetStructOfArrays().GetRealData(comp);
+            amrex::Gpu::copyAsync(amrex::Gpu::deviceToHost, rdata.begin() + box_offset,
+                                  rdata.begin() + box_offset + np, soa_buf.begin());
+            amrex::Gpu::streamSynchronize();
+            ofs.write(reinterpret_cast<const char*>(soa_buf.dataPtr()),
+                      np*sizeof(amrex::ParticleReal));
+        }
+        m_num_written[ibeam] += np;
+    }
+
+    // last box of this step: close the blobs, then write the manifest
+    if (it == 0) {
+        for (auto& ofs : m_beam_files) {
+            ofs.close();
+            AMREX_ALWAYS_ASSERT_WITH_MESSAGE(!ofs.fail(), "Failed to write checkpoint " + dir);
+        }
+        m_beam_files.clear();
+        // the manifest holds the number of particles summed over the transverse ranks
+        amrex::Vector<amrex::Long> num_written(m_num_written.begin(), m_num_written.end());
+        amrex::ParallelReduce::Sum(num_written.dataPtr(), nbeams, 0,
+                                   Hipace::GetInstance().m_comm_xy);
+        for (int ibeam = 0; ibeam < nbeams; ibeam++) m_num_written[ibeam] = num_written[ibeam];
+        if (rank_xy == 0) WriteHeader(dir, beams, step, physical_time, dt);
+    }
+}
+
+void
+Checkpoint::WriteHeader (const std::string& dir, MultiBeam& beams, const int step,
+                         const amrex::Real physical_time, const amrex::Real dt) const
+{
+    const std::string filename = dir + "/Header";
+    std::ofstream ofs(filename);
+    if (!ofs.good()) amrex::FileOpenFailed(filename);
+
+    ofs << std::setprecision(std::numeric_limits<amrex::Real>::max_digits10);
+    ofs << checkpoint_version << "\n";
+    ofs << "step " << step << "\n";
+    ofs << "physical_time " << physical_time << "\n";
+    ofs << "dt " << dt << "\n";
+    const Hipace& hipace = Hipace::GetInstance();
+    ofs << "nprocs_xy " << hipace.m_numprocs_x * hipace.m_numprocs_y << "\n";
+    ofs << "nthreads " << amrex::OpenMP::get_max_threads() << "\n";
+    ofs << "sizeof_particle " << sizeof(BeamParticleContainer::ParticleType) << "\n";
+    ofs << "sizeof_real " << sizeof(amrex::ParticleReal) << "\n";
+    ofs << "nbeams " << beams.get_nbeams() << "\n";
+    for (int ibeam = 0; ibeam < beams.get_nbeams(); ibeam++) {
+        ofs << beams.get_name(ibeam) << " " << m_num_written[ibeam] << "\n";
+    }
+    ofs.close();
+    AMREX_ALWAYS_ASSERT_WITH_MESSAGE(!ofs.fail(), "Failed to write " + filename);
+}
+
+void
+Checkpoint::ReadHeader ()
+{
+    const std::string filename = m_restart_dir + "/Header";
+    amrex::Vector<char> file_chars;
+    amrex::ParallelDescriptor::ReadAndBcastFile(filename, file_chars);
+    std::istringstream is(file_chars.dataPtr(), std::istringstream::in);
+
+    std::string version;
+    is >> version;
+    AMREX_ALWAYS_ASSERT_WITH_MESSAGE(version == checkpoint_version,
+        "Unknown checkpoint format " + version + " in " + filename);
+    ReadHeaderEntry(is, "step", m_restart_step);
+    ReadHeaderEntry(is, "physical_time", m_restart_time);
+    ReadHeaderEntry(is, "dt", m_restart_dt);
+    ReadHeaderEntry(is, "nprocs_xy", m_restart_nprocs_xy);
+    ReadHeaderEntry(is, "nthreads", m_restart_nthreads);
+    std::size_t sizeof_particle = 0, sizeof_real = 0;
+    ReadHeaderEntry(is, "sizeof_particle", sizeof_particle);
+    ReadHeaderEntry(is, "sizeof_real", sizeof_real);
+    AMREX_ALWAYS_ASSERT_WITH_MESSAGE(
+        sizeof_particle == sizeof(BeamParticleContainer::ParticleType) &&
+        sizeof_real == sizeof(amrex::ParticleReal),
+        "The checkpoint was written by a build with a different particle precision");
+    int nbeams = 0;
+    ReadHeaderEntry(is, "nbeams", nbeams);
+    m_restart_beam_names.resize(nbeams);
+    m_restart_num_particles.resize(nbeams);
+    for (int ibeam = 0; ibeam < nbeams; ibeam++) {
+        is >> m_restart_beam_names[ibeam] >> m_restart_num_particles[ibeam];
+    }
+    AMREX_ALWAYS_ASSERT_WITH_MESSAGE(!is.fail(), "Invalid checkpoint header " + filename);
+}
+
+void
+Checkpoint::ReadBeams (MultiBeam& beams, const bool is_head, const int rank_xy)
+{
+    HIPACE_PROFILE("Checkpoint::ReadBeams()");
+
+    using ParticleType = BeamParticleContainer::ParticleType;
+    const int nbeams = beams.get_nbeams();
+    AMREX_ALWAYS_ASSERT_WITH_MESSAGE(nbeams == static_cast<int>(m_restart_beam_names.size()),
+        "The number of beams differs from the one in the checkpoint");
+
+    amrex::Vector<ParticleType> aos_buf;
+    amrex::Vector<amrex::ParticleReal> soa_buf;
+    for (int ibeam = 0; ibeam < nbeams; ibeam++) {
+        auto& beam = beams.getBeam(ibeam);
+        AMREX_ALWAYS_ASSERT_WITH_MESSAGE(beam.get_name() == m_restart_beam_names[ibeam],
+            "Beam " + beam.get_name() + " is not in the checkpoint, or not in the same order");
+        beam.resize(0);
+
+        amrex::Long num_read = 0;
+        if (is_head) {
+            const std::string filename = BeamFileName(m_restart_dir, beam.get_name(), rank_xy);
+            std::ifstream ifs(filename, std::ios::in | std::ios::binary);
+            if (!ifs.good()) amrex::FileOpenFailed(filename);
+
+            // read the chunks written box by box, until the end of the file
+            uint64_t np = 0;
+            while (ifs.read(reinterpret_cast<char*>(&np), sizeof(np))) {
+                if (np == 0) continue;
+                const uint64_t old_size = beam.numParticles();
+                beam.resize(old_size + np);
+
+                aos_buf.resize(np);
+                ifs.read(reinterpret_cast<char*>(aos_buf.dataPtr()), np*sizeof(ParticleType));
+                auto& aos = beam.GetArrayOfStructs()();
+                amrex::Gpu::copyAsync(amrex::Gpu::hostToDevice, aos_buf.begin(), aos_buf.end(),
+                                      aos.begin() + old_size);
+                amrex::Gpu::streamSynchronize();
+
+                soa_buf.resize(np);
+                for (int comp=0; comp<BeamIdx::nattribs; ++comp) {
+                    ifs.read(reinterpret_cast<char*>(soa_buf.dataPtr()),
+                             np*sizeof(amrex::ParticleReal));
+                    auto& rdata = beam.GetStructOfArrays().GetRealData(comp);
+                    amrex::Gpu::copyAsync(amrex::Gpu::hostToDevice, soa_buf.begin(),
+                                          soa_buf.end(), rdata.begin() + old_size);
+                    amrex::Gpu::streamSynchronize();
+                }
+                AMREX_ALWAYS_ASSERT_WITH_MESSAGE(!ifs.fail(), "Truncated checkpoint " + filename);
+                num_read += np;
+            }
+        }
+
+        // the head ranks of all transverse ranks together must read the whole beam
+        amrex::ParallelDescriptor::ReduceLongSum(num_read);
+        AMREX_ALWAYS_ASSERT_WITH_MESSAGE(
+            static_cast<uint64_t>(num_read) == m_restart_num_particles[ibeam],
+            "Beam " + beam.get_name() + ": " + std::to_string(num_read) + " particles read, " +
+            std::to_string(m_restart_num_particles[ibeam]) + " in the checkpoint header");
+
+        /* setting total number of particles, which is required for openPMD I/O */
+        beam.m_total_num_particles = beam.TotalNumberOfParticles();
+    }
+}
+
+void
+Checkpoint::ReadRandomState (const int rank_xy)
+{
+#ifndef AMREX_USE_GPU
+    const std::string filename = amrex::Concatenate(m_restart_dir + "/rng.", rank_xy, 5);
+    std::ifstream ifs(filename);
+    if (!ifs.good()) amrex::FileOpenFailed(filename);
+    amrex::RestoreRandomState(ifs, m_restart_nthreads, m_restart_step);
+#else
+    amrex::ignore_unused(rank_xy);
+    amrex::Print() << "WARNING: the random state is not restored on GPU, random processes "
+                   << "such as ionization are not reproduced by the restart\n";
+#endif
+}
@@ -22,6 +22,16 @@ Diagnostic::Diagnostic (int nlev)
         amrex::Abort("Unknown diagnostics type: must be xyz, xz or yz.");
     }
 
+    amrex::Array<int, AMREX_SPACEDIM> diag_coarsen_arr {1, 1, 1};
+    ppd.query("coarsening", diag_coarsen_arr);
+    for (int idim=0; idim<AMREX_SPACEDIM; ++idim) {
+        AMREX_ALWAYS_ASSERT_WITH_MESSAGE(diag_coarsen_arr[idim] >= 1,
+                                         "diagnostic.coarsening must be >= 1");
+        m_diag_coarsen[idim] = diag_coarsen_arr[idim];
+    }
+    // There is only one cell in the slicing direction
+    if (m_slice_dir >= 0) m_diag_coarsen[m_slice_dir] = 1;
+
     ppd.queryarr("field_data", m_comps_output);
     const amrex::Vector<std::string> all_field_comps
             {"ExmBy", "EypBx", "Ez", "Bx", "By", "Bz", "jx", "jx_beam", "jy", "jy_beam", "jz",
@@ -92,6 +102,9 @@ Diagnostic::AllocData (int lev, const amrex::Box& bx, int nfields, amrex::Geomet
         int const icenter = domain.length(m_slice_dir)/2;
         domain.setSmall(m_slice_dir, icenter);
         domain.setBig(m_slice_dir, icenter);
+    }
+    if (m_slice_dir >= 0 || m_diag_coarsen != amrex::IntVect(1)){
+        domain.coarsen(m_diag_coarsen);
         m_geom_io[lev] = amrex::Geometry(domain, &prob_domain, geom.Coord());
     }
 }
@@ -101,6 +114,8 @@ Diagnostic::ResizeFDiagFAB (const amrex::Box box, const int lev)
 {
     amrex::Box io_box = TrimIOBox(box);
     m_F[lev].resize(io_box, m_nfields);
+    // coarsened fields are accumulated slice by slice
+    if (m_diag_coarsen != amrex::IntVect(1)) m_F[lev].setVal<amrex::RunOn::Host>(0.);
  }
 
 amrex::Box
@@ -116,5 +131,10 @@ Diagnostic::TrimIOBox (const amrex::Box box_3d)
     // m_F is defined on F_bx, the full or the slice Box
     amrex::Box F_bx = m_slice_dir >= 0 ? slice_bx : box_3d;
 
+    // a coarse cell must not be shared by two boxes
+    AMREX_ALWAYS_ASSERT_WITH_MESSAGE(F_bx.coarsenable(m_diag_coarsen),
+        "The boxes must be divisible by diagnostic.coarsening");
+    F_bx.coarsen(m_diag_coarsen);
+
     return F_bx;
 }
@@ -3,6 +3,10 @@
 #include "utils/HipaceProfilerWrapper.H"
 #include "utils/Constants.H"
 #include "utils/IOUtil.H"
+#include "particles/pusher/GetAndSetPosition.H"
+
+#include <algorithm>
+#include <exception>
 
 #ifdef HIPACE_USE_OPENPMD
 
@@ -17,6 +21,70 @@ OpenPMDWriter::OpenPMDWriter ()
     // temporary workaround until openPMD-viewer gets fixed
     amrex::ParmParse ppd("diagnostic");
     ppd.query("openpmd_viewer_u_workaround", m_openpmd_viewer_workaround);
+    ppd.query("async_write", m_async_io);
+}
+
+OpenPMDWriter::~OpenPMDWriter ()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_io_mutex);
+        m_io_stop = true;
+    }
+    m_io_cv.notify_all();
+    if (m_io_thread.joinable()) m_io_thread.join();
+}
+
+void
+OpenPMDWriter::SubmitIOTask (std::function<void()>&& task)
+{
+    if (!m_async_io) {
+        task();
+        return;
+    }
+    HIPACE_PROFILE("OpenPMDWriter::SubmitIOTask()");
+    std::unique_lock<std::mutex> lock(m_io_mutex);
+    if (!m_io_thread.joinable()) {
+        m_io_thread = std::thread(&OpenPMDWriter::IOThreadLoop, this);
+    }
+    m_io_cv.wait(lock, [this]{ return m_io_pending < m_max_pending_io_tasks; });
+    m_io_tasks.push_back(std::move(task));
+    ++m_io_pending;
+    lock.unlock();
+    m_io_cv.notify_all();
+}
+
+void
+OpenPMDWriter::IOThreadLoop ()
+{
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(m_io_mutex);
+            m_io_cv.wait(lock, [this]{ return m_io_stop || !m_io_tasks.empty(); });
+            if (m_io_tasks.empty()) return;
+            task = std::move(m_io_tasks.front());
+            m_io_tasks.pop_front();
+        }
+        try {
+            task();
+        } catch (const std::exception& e) {
+            amrex::Abort(std::string("openPMD IO thread: ") + e.what());
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_io_mutex);
+            --m_io_pending;
+        }
+        m_io_cv.notify_all();
+    }
+}
+
+void
+OpenPMDWriter::WaitIOTasks ()
+{
+    if (!m_async_io) return;
+    HIPACE_PROFILE("OpenPMDWriter::WaitIOTasks()");
+    std::unique_lock<std::mutex> lock(m_io_mutex);
+    m_io_cv.wait(lock, [this]{ return m_io_pending == 0; });
 }
 
 void
@@ -29,35 +97,36 @@ OpenPMDWriter::InitDiagnostics (const int output_step, const int output_period,
     if (output_period < 0 ||
        (!(output_step == max_step) && output_step % output_period != 0)) return;
 
-    // pick first available backend if default is chosen
-    if( m_openpmd_backend == "default" ) {
+    // The series are created by the IO thread in async mode, as it accesses m_outputSeries
+    SubmitIOTask([this, nlev] () {
+        // pick first available backend if default is chosen
+        if( m_openpmd_backend == "default" ) {
 #if openPMD_HAVE_HDF5==1
-        m_openpmd_backend = "h5";
+            m_openpmd_backend = "h5";
 #elif openPMD_HAVE_ADIOS2==1
-        m_openpmd_backend = "bp";
+            m_openpmd_backend = "bp";
 #else
-        m_openpmd_backend = "json";
+            m_openpmd_backend = "json";
 #endif
-    }
+        }
 
-    if (nlev > 1) {
-        for (int lev=0; lev<nlev; ++lev) {
-            std::string filename = m_file_prefix + "/lev_" + std::to_string(lev) +  "/openpmd_%06T."
-                                   + m_openpmd_backend;
+        if (nlev > 1) {
+            for (int lev=0; lev<nlev; ++lev) {
+                std::string filename = m_file_prefix + "/lev_" + std::to_string(lev)
+                                       + "/openpmd_%06T." + m_openpmd_backend;
+
+                m_outputSeries.push_back(std::make_unique< openPMD::Series >(
+                    filename, openPMD::Access::CREATE) );
+                m_last_output_dumped.push_back(-1);
+            }
+        } else {
+            std::string filename = m_file_prefix + "/openpmd_%06T." + m_openpmd_backend;
 
             m_outputSeries.push_back(std::make_unique< openPMD::Series >(
                 filename, openPMD::Access::CREATE) );
             m_last_output_dumped.push_back(-1);
         }
-    } else {
-        std::string filename = m_file_prefix + "/openpmd_%06T." + m_openpmd_backend;
-
-        m_outputSeries.push_back(std::make_unique< openPMD::Series >(
-            filename, openPMD::Access::CREATE) );
-        m_last_output_dumped.push_back(-1);
-    }
-
-
+    });
 
     // TODO: meta-data: author, mesh path, extensions, software
 }
@@ -72,21 +141,49 @@ OpenPMDWriter::WriteDiagnostics (
     const amrex::Vector<BoxSorter>& a_box_sorter_vec, amrex::Vector<amrex::Geometry> const& geom3D,
     const OpenPMDWriterCallType call_type)
 {
-    for (int lev=0; lev<nlev; ++lev) {
-        openPMD::Iteration iteration = m_outputSeries[lev]->iterations[output_step];
-
-        if (call_type == OpenPMDWriterCallType::beams ) {
-            iteration.setTime(physical_time);
-            if (lev == 0) {
-                WriteBeamParticleData(a_multi_beam, iteration, output_step, it, a_box_sorter_vec, geom3D[lev], beamnames, lev);
+    if (call_type == OpenPMDWriterCallType::beams ) {
+        // The beam data of this box is copied out of the containers, so the IO can happen
+        // while the particles are pushed
+        auto beam_data = std::make_shared<amrex::Vector<BeamOutputData>>(
+            StageBeamParticleData(a_multi_beam, it, a_box_sorter_vec, beamnames));
+        const amrex::Geometry geom_beam = geom3D[0];
+        SubmitIOTask([this, beam_data, geom_beam, physical_time, output_step, nlev, it] () {
+            for (int lev=0; lev<nlev; ++lev) {
+                openPMD::Iteration iteration = m_outputSeries[lev]->iterations[output_step];
+                iteration.setTime(physical_time);
+                if (lev == 0) {
+                    WriteBeamParticleData(*beam_data, iteration, output_step, it, geom_beam,
+                                          lev);
+                }
+                m_outputSeries[lev]->flush();
             }
-            m_outputSeries[lev]->flush();
-
-        } else if (call_type == OpenPMDWriterCallType::fields ) {
-            WriteFieldData(a_mf[lev], geom[lev], slice_dir, varnames, iteration, output_step, lev);
-            m_outputSeries[lev]->flush();
-            m_last_output_dumped[lev] = output_step;
+        });
+
+    } else if (call_type == OpenPMDWriterCallType::fields ) {
+        // In async mode, the diagnostics FArrayBoxes are overwritten by the next box while they
+        // are written, so a copy is handed to the IO thread
+        std::shared_ptr<amrex::Vector<amrex::FArrayBox>> mf_copy;
+        amrex::Vector<amrex::FArrayBox> const* mf = &a_mf;
+        if (m_async_io) {
+            HIPACE_PROFILE("OpenPMDWriter::CopyFields()");
+            mf_copy = std::make_shared<amrex::Vector<amrex::FArrayBox>>();
+            for (int lev=0; lev<nlev; ++lev) {
+                mf_copy->emplace_back(a_mf[lev].box(), a_mf[lev].nComp(),
+                                      amrex::The_Pinned_Arena());
+                mf_copy->back().copy<amrex::RunOn::Host>(a_mf[lev]);
+            }
+            mf = mf_copy.get();
         }
+        const amrex::Vector<amrex::Geometry> geom_fields = geom;
+        SubmitIOTask([this, mf, mf_copy, geom_fields, slice_dir, varnames, output_step, nlev] () {
+            for (int lev=0; lev<nlev; ++lev) {
+                openPMD::Iteration iteration = m_outputSeries[lev]->iterations[output_step];
+                WriteFieldData((*mf)[lev], geom_fields[lev], slice_dir, varnames, iteration,
+                               output_step, lev);
+                m_outputSeries[lev]->flush();
+                m_last_output_dumped[lev] = output_step;
+            }
+        });
     }
 }
 
@@ -161,29 +258,160 @@ OpenPMDWriter::WriteFieldData (
 }
 
 void
-OpenPMDWriter::WriteBeamParticleData (MultiBeam& beams, openPMD::Iteration iteration,
-                                      const int output_step, const int it,
+OpenPMDWriter::StageBoxParticleData (BeamParticleContainer& beam, const BeamOutputFilter& filter,
+                                     const uint64_t box_offset, BeamOutputData& data)
+{
+    HIPACE_PROFILE("StageBoxParticleData()");
+
+    const int np = data.m_num_particles;
+    const auto getPosition = GetParticlePosition<BeamParticleContainer>(beam, box_offset);
+    const auto& soa = beam.GetStructOfArrays();
+    amrex::GpuArray<const amrex::ParticleReal*, BeamIdx::nattribs> real_data;
+    for (int idx=0; idx<BeamIdx::nattribs; idx++) {
+        real_data[idx] = soa.GetRealData(idx).dataPtr() + box_offset;
+    }
+
+    // evaluate the filter and compact the indices of the selected particles
+    amrex::Gpu::DeviceVector<int> selected;
+    int* p_selected = nullptr;
+    int n_selected = np;
+    if (data.m_filtered) {
+        const amrex::Real inv_c = 1. / get_phys_const().c;
+        const amrex::ParticleReal* uzp = real_data[BeamIdx::uz];
+        selected.resize(np);
+        p_selected = selected.dataPtr();
+        int* const p_sel = p_selected;
+        n_selected = amrex::Scan::PrefixSum<int>(np,
+            [=] AMREX_GPU_DEVICE (int i) -> int {
+                amrex::ParticleReal xp, yp, zp;
+                int pid, pcpu;
+                getPosition(i, xp, yp, zp, pid, pcpu);
+                return pid >= 0 &&
+                    filter(zp, uzp[i]*inv_c, utils::localIDtoGlobal(pid, pcpu));
+            },
+            [=] AMREX_GPU_DEVICE (int i, int const& s) {
+                amrex::ParticleReal xp, yp, zp;
+                int pid, pcpu;
+                getPosition(i, xp, yp, zp, pid, pcpu);
+                if (pid >= 0 && filter(zp, uzp[i]*inv_c, utils::localIDtoGlobal(pid, pcpu))) {
+                    p_sel[s] = i;
+                }
+            },
+            amrex::Scan::Type::exclusive, amrex::Scan::retSum);
+    }
+
+    data.m_num_particles = n_selected;
+    if (n_selected == 0) return;
+
+    // One pinned staging block holds all components of this box, in SoA layout. It is allocated
+    // from the caching pinned arena, so blocks are reused across boxes and steps, and it is
+    // released when the last component has been flushed, possibly by the IO thread.
+    constexpr int ncomps = AMREX_SPACEDIM + BeamIdx::nattribs;
+    const std::size_t nbytes = n_selected * (ncomps*sizeof(amrex::ParticleReal)
+                                             + sizeof(uint64_t));
+    std::shared_ptr<char> block(static_cast<char*>(amrex::The_Pinned_Arena()->alloc(nbytes)),
+                                [](char* p){ amrex::The_Pinned_Arena()->free(p); });
+    uint64_t* const p_ids = reinterpret_cast<uint64_t*>(block.get());
+    amrex::ParticleReal* const p_reals =
+        reinterpret_cast<amrex::ParticleReal*>(block.get() + n_selected*sizeof(uint64_t));
+
+    // transpose the AoS positions and gather the SoA data in a single pass on the device,
+    // writing directly to the pinned staging block
+    amrex::ParallelFor(n_selected,
+        [=] AMREX_GPU_DEVICE (int j) {
+            const int i = p_selected ? p_selected[j] : j;
+            amrex::ParticleReal xp, yp, zp;
+            int pid, pcpu;
+            getPosition(i, xp, yp, zp, pid, pcpu);
+            p_reals[0*n_selected + j] = xp;
+            p_reals[1*n_selected + j] = yp;
+            p_reals[2*n_selected + j] = zp;
+            for (int idx=0; idx<BeamIdx::nattribs; idx++) {
+                p_reals[(AMREX_SPACEDIM+idx)*n_selected + j] = real_data[idx][i];
+            }
+            // convert the particle ID to a globally unique ID
+            p_ids[j] = utils::localIDtoGlobal( pid, pcpu );
+        });
+    amrex::Gpu::streamSynchronize();
+
+    // non-owning views into the block, which is kept alive by the aliasing shared_ptrs
+    for (int comp=0; comp<ncomps; comp++) {
+        std::shared_ptr<amrex::ParticleReal> view(block, p_reals + comp*n_selected);
+        if (comp < AMREX_SPACEDIM) {
+            data.m_positions.push_back(view);
+        } else {
+            data.m_real_data.push_back(view);
+        }
+    }
+    data.m_ids = std::shared_ptr<uint64_t>(block, p_ids);
+}
+
+amrex::Vector<BeamOutputData>
+OpenPMDWriter::StageBeamParticleData (MultiBeam& beams, const int it,
                                       const amrex::Vector<BoxSorter>& a_box_sorter_vec,
-                                      const amrex::Geometry& geom,
-                                      const amrex::Vector< std::string > beamnames, const int lev)
+                                      const amrex::Vector< std::string > beamnames)
 {
-    HIPACE_PROFILE("WriteBeamParticleData()");
+    HIPACE_PROFILE("StageBeamParticleData()");
 
+    amrex::Vector<BeamOutputData> beam_data;
     const int nbeams = beams.get_nbeams();
+    for (int ibeam = 0; ibeam < nbeams; ibeam++) {
+
+        BeamOutputData data;
+        data.m_name = beams.get_name(ibeam);
+        if(std::find(beamnames.begin(), beamnames.end(), data.m_name) ==  beamnames.end() ) {
+            continue;
+        }
+
+        auto& beam = beams.getBeam(ibeam);
+        data.m_np_total = beams.get_total_num_particles(ibeam);
+        data.m_charge = beam.m_charge;
+        data.m_mass = beam.m_mass;
+
+        const uint64_t box_offset = a_box_sorter_vec[ibeam].boxOffsetsPtr()[it];
+        auto const numParticleOnTile = a_box_sorter_vec[ibeam].boxCountsPtr()[it];
+        data.m_num_particles = static_cast<uint64_t>( numParticleOnTile );
+
+        const BeamOutputFilter filter = beam.m_output_filter;
+        data.m_filtered = filter.isActive();
+
+        if (numParticleOnTile > 0) {
+            StageBoxParticleData(beam, filter, box_offset, data);
+        }
+        beam_data.push_back(std::move(data));
+    }
+    return beam_data;
+}
+
+void
+OpenPMDWriter::WriteBeamParticleData (const amrex::Vector<BeamOutputData>& beam_data,
+                                      openPMD::Iteration iteration, const int output_step,
+                                      const int it, const amrex::Geometry& geom, const int lev)
+{
+    const int nbeams = beam_data.size();
     m_offset.resize(nbeams);
     m_tmp_offset.resize(nbeams);
     for (int ibeam = 0; ibeam < nbeams; ibeam++) {
 
-        std::string name = beams.get_name(ibeam);
-        if(std::find(beamnames.begin(), beamnames.end(), name) ==  beamnames.end() ) continue;
+        const BeamOutputData& data = beam_data[ibeam];
 
-        openPMD::ParticleSpecies beam_species = iteration.particles[name];
+        if (data.m_filtered) {
+            // filtered beams are written at once after the last box, as the size of the
+            // dataset is only known then
+            auto& boxes = m_filtered_beam_data[data.m_name];
+            if (data.m_num_particles > 0) boxes.push_back(data);
+            if (it == 0) {
+                WriteFilteredBeamParticleData(boxes, data, iteration, geom);
+                boxes.clear();
+            }
+            continue;
+        }
 
-        auto& beam = beams.getBeam(ibeam);
+        openPMD::ParticleSpecies beam_species = iteration.particles[data.m_name];
 
-        const unsigned long long np = beams.get_total_num_particles(ibeam);
+        const unsigned long long np = data.m_np_total;
         if (m_last_output_dumped[lev] != output_step) {
-            SetupPos(beam_species, beam, np, geom);
+            SetupPos(beam_species, data.m_charge, data.m_mass, np, geom);
             SetupRealProperties(beam_species, m_real_names, np);
         }
 
@@ -194,60 +422,67 @@ OpenPMDWriter::WriteBeamParticleData (MultiBeam& beams, openPMD::Iteration itera
         } else {
             m_offset[ibeam] += m_tmp_offset[ibeam];
         }
-        const uint64_t box_offset = a_box_sorter_vec[ibeam].boxOffsetsPtr()[it];
 
-        auto const numParticleOnTile = a_box_sorter_vec[ibeam].boxCountsPtr()[it];
-        uint64_t const numParticleOnTile64 = static_cast<uint64_t>( numParticleOnTile );
+        uint64_t const numParticleOnTile64 = data.m_num_particles;
 
-        if (numParticleOnTile == 0) {
+        if (numParticleOnTile64 == 0) {
             m_tmp_offset[ibeam] = 0;
             continue;
         }
 
-        // get position and particle ID from aos
-        // note: this implementation iterates the AoS 4x...
-        // if we flush late as we do now, we can also copy out the data in one go
-        const auto& aos = beam.GetArrayOfStructs();  // size =  numParticlesOnTile
-        const auto& pos_structs = aos.begin() + box_offset;
         {
             // Save positions
             std::vector< std::string > const positionComponents{"x", "y", "z"};
-
-            for (auto currDim = 0; currDim < AMREX_SPACEDIM; currDim++)
-            {
-                std::shared_ptr< amrex::ParticleReal > curr(
-                    new amrex::ParticleReal[numParticleOnTile],
-                    [](amrex::ParticleReal const *p){ delete[] p; } );
-
-                for (uint64_t i=0; i<numParticleOnTile; i++) {
-                    curr.get()[i] = pos_structs[i].pos(currDim);
-                }
+            for (auto currDim = 0; currDim < AMREX_SPACEDIM; currDim++) {
                 std::string const positionComponent = positionComponents[currDim];
-                beam_species["position"][positionComponent].storeChunk(curr, {m_offset[ibeam]},
-                                                                       {numParticleOnTile64});
+                beam_species["position"][positionComponent].storeChunk(
+                    data.m_positions[currDim], {m_offset[ibeam]}, {numParticleOnTile64});
             }
 
-            // save particle ID after converting it to a globally unique ID
-            std::shared_ptr< uint64_t > ids( new uint64_t[numParticleOnTile],
-                                             [](uint64_t const *p){ delete[] p; } );
-
-            for (uint64_t i=0; i<numParticleOnTile; i++) {
-                ids.get()[i] = utils::localIDtoGlobal( aos[i].id(), aos[i].cpu() );
-            }
+            // save particle ID
             auto const scalar = openPMD::RecordComponent::SCALAR;
-            beam_species["id"][scalar].storeChunk(ids, {m_offset[ibeam]}, {numParticleOnTile64});
+            beam_species["id"][scalar].storeChunk(data.m_ids, {m_offset[ibeam]},
+                                                  {numParticleOnTile64});
         }
         //  save "extra" particle properties in SoA (momenta and weight)
-        SaveRealProperty(beam, beam_species, m_offset[ibeam], m_real_names, box_offset,
-                         numParticleOnTile);
+        SaveRealProperty(data, beam_species, m_offset[ibeam], m_real_names);
 
          m_tmp_offset[ibeam] = numParticleOnTile64;
     }
 }
 
 void
-OpenPMDWriter::SetupPos (openPMD::ParticleSpecies& currSpecies, BeamParticleContainer& beam,
-                         const unsigned long long& np, const amrex::Geometry& geom)
+OpenPMDWriter::WriteFilteredBeamParticleData (const amrex::Vector<BeamOutputData>& boxes,
+                                              const BeamOutputData& last_box,
+                                              openPMD::Iteration iteration,
+                                              const amrex::Geometry& geom)
+{
+    uint64_t np = 0;
+    for (const auto& box_data : boxes) np += box_data.m_num_particles;
+
+    openPMD::ParticleSpecies beam_species = iteration.particles[last_box.m_name];
+    SetupPos(beam_species, last_box.m_charge, last_box.m_mass, np, geom);
+    SetupRealProperties(beam_species, m_real_names, np);
+
+    std::vector< std::string > const positionComponents{"x", "y", "z"};
+    auto const scalar = openPMD::RecordComponent::SCALAR;
+    uint64_t offset = 0;
+    for (const auto& box_data : boxes) {
+        const uint64_t n = box_data.m_num_particles;
+        for (auto currDim = 0; currDim < AMREX_SPACEDIM; currDim++) {
+            beam_species["position"][positionComponents[currDim]].storeChunk(
+                box_data.m_positions[currDim], {offset}, {n});
+        }
+        beam_species["id"][scalar].storeChunk(box_data.m_ids, {offset}, {n});
+        SaveRealProperty(box_data, beam_species, offset, m_real_names);
+        offset += n;
+    }
+}
+
+void
+OpenPMDWriter::SetupPos (openPMD::ParticleSpecies& currSpecies, const amrex::Real charge,
+                         const amrex::Real mass, const unsigned long long& np,
+                         const amrex::Geometry& geom)
 {
     const PhysConst phys_const_SI = make_constants_SI();
     auto const realType = openPMD::Dataset(openPMD::determineDatatype<amrex::ParticleReal>(), {np});
@@ -263,9 +498,9 @@ OpenPMDWriter::SetupPos (openPMD::ParticleSpecies& currSpecies, BeamParticleCont
     auto const scalar = openPMD::RecordComponent::SCALAR;
     currSpecies["id"][scalar].resetDataset( idType );
     currSpecies["charge"][scalar].resetDataset( realType );
-    currSpecies["charge"][scalar].makeConstant( beam.m_charge );
+    currSpecies["charge"][scalar].makeConstant( charge );
     currSpecies["mass"][scalar].resetDataset( realType );
-    currSpecies["mass"][scalar].makeConstant( beam.m_mass );
+    currSpecies["mass"][scalar].makeConstant( mass );
 
     // meta data
     currSpecies["position"].setUnitDimension( utils::getUnitDimension("position") );
@@ -355,18 +590,15 @@ OpenPMDWriter::SetupRealProperties (openPMD::ParticleSpecies& currSpecies,
 }
 
 void
-OpenPMDWriter::SaveRealProperty (BeamParticleContainer& pc,
+OpenPMDWriter::SaveRealProperty (const BeamOutputData& data,
                                  openPMD::ParticleSpecies& currSpecies,
                                  unsigned long long const offset,
-                                 amrex::Vector<std::string> const& real_comp_names,
-                                 unsigned long long const box_offset,
-                                 const unsigned long long numParticleOnTile)
+                                 amrex::Vector<std::string> const& real_comp_names)
 {
     /* we have 4 SoA real attributes: weight, ux, uy, uz */
     int const NumSoARealAttributes = real_comp_names.size();
 
-    uint64_t const numParticleOnTile64 = static_cast<uint64_t>( numParticleOnTile );
-    auto const& soa = pc.GetStructOfArrays();
+    uint64_t const numParticleOnTile64 = data.m_num_particles;
     {
         for (int idx=0; idx<NumSoARealAttributes; idx++) {
 
@@ -376,14 +608,14 @@ OpenPMDWriter::SaveRealProperty (BeamParticleContainer& pc,
             auto& currRecord = currSpecies[record_name];
             auto& currRecordComp = currRecord[component_name];
 
-            currRecordComp.storeChunk(openPMD::shareRaw(soa.GetRealData(idx).data()+box_offset),
-                {offset}, {numParticleOnTile64});
+            currRecordComp.storeChunk(data.m_real_data[idx], {offset}, {numParticleOnTile64});
         } // end for NumSoARealAttributes
     }
 }
 
 void OpenPMDWriter::reset ()
 {
+    WaitIOTasks();
     for (int lev = 0; lev<m_outputSeries.size(); ++lev) {
         m_outputSeries[lev].reset();
     }
@@ -0,0 +1,228 @@
+#include "ReducedDiagnostics.H"
+#include "Hipace.H"
+#include "particles/pusher/GetAndSetPosition.H"
+#include "utils/Constants.H"
+#include "utils/HipaceProfilerWrapper.H"
+
+#include <AMReX_ParallelReduce.H>
+#include <AMReX_ParmParse.H>
+#include <AMReX_Utility.H>
+
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+
+ReducedDiagnostics::ReducedDiagnostics ()
+{
+    amrex::ParmParse ppd("diagnostic");
+    ppd.query("reduced_period", m_period);
+    ppd.query("reduced_file_prefix", m_file_prefix);
+}
+
+bool
+ReducedDiagnostics::doDiagnostics (const int step, const int max_step) const
+{
+    // Dump every m_period steps and after last step
+    return !(m_period <= 0 || (!(step == max_step) && step % m_period != 0));
+}
+
+void
+ReducedDiagnostics::InitStep (const int step, const int max_step, const int nbeams,
+                              const amrex::Geometry& geom)
+{
+    m_active = doDiagnostics(step, max_step);
+    if (!m_active) return;
+    HIPACE_PROFILE("ReducedDiagnostics::InitStep()");
+
+    m_step = step;
+    m_nbeams = nbeams;
+    m_nslices = geom.Domain().length(Direction::z);
+    m_beam_moments.resize(m_nbeams*m_nslices*BeamMoment::N);
+    m_lineouts.resize(m_nslices*LineoutComp::N);
+    amrex::Real* moments = m_beam_moments.dataPtr();
+    amrex::Real* lineouts = m_lineouts.dataPtr();
+    amrex::ParallelFor(m_beam_moments.size(), [=] AMREX_GPU_DEVICE (long i) { moments[i] = 0.; });
+    amrex::ParallelFor(m_lineouts.size(), [=] AMREX_GPU_DEVICE (long i) { lineouts[i] = 0.; });
+}
+
+void
+ReducedDiagnostics::AccumulateSlice (MultiBeam& beams, Fields& fields,
+                                     const amrex::Geometry& geom, const int islice,
+                                     const amrex::Box& bx, amrex::Vector<BeamBins>& bins,
+                                     const amrex::Vector<BoxSorter>& a_box_sorter_vec,
+                                     const int ibox)
+{
+    using namespace amrex::literals;
+
+    if (!m_active) return;
+    HIPACE_PROFILE("ReducedDiagnostics::AccumulateSlice()");
+
+    const int islice_domain = islice - geom.Domain().smallEnd(Direction::z);
+    const int islice_local = islice - bx.smallEnd(Direction::z);
+    const PhysConst phys_const = get_phys_const();
+    const amrex::Real inv_c = 1._rt / phys_const.c;
+
+    for (int ibeam=0; ibeam<m_nbeams; ++ibeam) {
+        auto& beam = beams.getBeam(ibeam);
+        const int offset = a_box_sorter_vec[ibeam].boxOffsetsPtr()[ibox];
+
+        BeamBins::index_type const * const indices = getBinPermutation(bins[ibeam], beam);
+        BeamBins::index_type const * const offsets = bins[ibeam].offsetsPtr();
+        BeamBins::index_type const
+            cell_start = offsets[islice_local], cell_stop = offsets[islice_local+1];
+        int const num_particles = cell_stop-cell_start;
+        if (num_particles == 0) continue;
+
+        auto& soa = beam.GetStructOfArrays();
+        const amrex::Real * const wp = soa.GetRealData(BeamIdx::w).data() + offset;
+        const amrex::Real * const uxp = soa.GetRealData(BeamIdx::ux).data() + offset;
+        const amrex::Real * const uyp = soa.GetRealData(BeamIdx::uy).data() + offset;
+        const amrex::Real * const uzp = soa.GetRealData(BeamIdx::uz).data() + offset;
+        const auto getPosition = GetParticlePosition<BeamParticleContainer>(beam, offset);
+
+        amrex::Real * const moments =
+            m_beam_moments.dataPtr() + (ibeam*m_nslices + islice_domain)*BeamMoment::N;
+
+        amrex::ParallelFor(
+            num_particles,
+            [=] AMREX_GPU_DEVICE (long idx) {
+                const int ip = indices ? indices[cell_start+idx] : cell_start+idx;
+                amrex::ParticleReal xp, yp, zp;
+                int pid;
+                getPosition(ip, xp, yp, zp, pid);
+                if (pid < 0) return;
+
+                const amrex::Real w = wp[ip];
+                const amrex::Real ux = uxp[ip] * inv_c;
+                const amrex::Real uy = uyp[ip] * inv_c;
+                const amrex::Real uz = uzp[ip] * inv_c;
+                const amrex::Real gamma = std::sqrt(1._rt + ux*ux + uy*uy + uz*uz);
+
+                using namespace amrex::Gpu;
+                Atomic::AddNoRet(moments + BeamMoment::w, w);
+                Atomic::AddNoRet(moments + BeamMoment::wx, w*xp);
+                Atomic::AddNoRet(moments + BeamMoment::wxx, w*xp*xp);
+                Atomic::AddNoRet(moments + BeamMoment::wy, w*yp);
+                Atomic::AddNoRet(moments + BeamMoment::wyy, w*yp*yp);
+                Atomic::AddNoRet(moments + BeamMoment::wux, w*ux);
+                Atomic::AddNoRet(moments + BeamMoment::wuxux, w*ux*ux);
+                Atomic::AddNoRet(moments + BeamMoment::wuy, w*uy);
+                Atomic::AddNoRet(moments + BeamMoment::wuyuy, w*uy*uy);
+                Atomic::AddNoRet(moments + BeamMoment::wxux, w*xp*ux);
+                Atomic::AddNoRet(moments + BeamMoment::wyuy, w*yp*uy);
+                Atomic::AddNoRet(moments + BeamMoment::wgamma, w*gamma);
+                Atomic::AddNoRet(moments + BeamMoment::wgammagamma, w*gamma*gamma);
+            });
+    }
+
+    // On-axis field lineouts, taken at the center of the domain. For an even number of cells,
+    // the two cells around the center are averaged, as for slice IO.
+    const amrex::IntVect ncells_global = geom.Domain().length();
+    const bool nx_even = ncells_global[0] % 2 == 0;
+    const bool ny_even = ncells_global[1] % 2 == 0;
+    const int ic = geom.Domain().smallEnd(0) + ncells_global[0]/2;
+    const int jc = geom.Domain().smallEnd(1) + ncells_global[1]/2;
+    const int iez = Comps[WhichSlice::This]["Ez"];
+    const int iexmby = Comps[WhichSlice::This]["ExmBy"];
+    amrex::Real * const lineouts = m_lineouts.dataPtr() + islice_domain*LineoutComp::N;
+
+    amrex::MultiFab& S = fields.getSlices(0, WhichSlice::This);
+    for (amrex::MFIter mfi(S); mfi.isValid(); ++mfi) {
+        const amrex::Box& vbx = mfi.validbox();
+        if (ic < vbx.smallEnd(0) || ic > vbx.bigEnd(0) ||
+            jc < vbx.smallEnd(1) || jc > vbx.bigEnd(1)) continue;
+        amrex::Array4<amrex::Real const> const arr = S.const_array(mfi);
+        const int k = vbx.smallEnd(Direction::z);
+        amrex::ParallelFor(1, [=] AMREX_GPU_DEVICE (int) {
+            const int nx = nx_even ? 2 : 1;
+            const int ny = ny_even ? 2 : 1;
+            amrex::Real ez = 0._rt;
+            amrex::Real exmby = 0._rt;
+            for (int j = jc-ny+1; j <= jc; ++j) {
+                for (int i = ic-nx+1; i <= ic; ++i) {
+                    ez += arr(i,j,k,iez);
+                    exmby += arr(i,j,k,iexmby);
+                }
+            }
+            lineouts[LineoutComp::Ez] = ez / (nx*ny);
+            lineouts[LineoutComp::ExmBy] = exmby / (nx*ny);
+        });
+    }
+}
+
+void
+ReducedDiagnostics::WriteStep (MultiBeam& beams, const amrex::Geometry& geom,
+                               const amrex::Real physical_time, const MPI_Comm& comm_xy,
+                               const int rank_xy)
+{
+    if (!m_active) return;
+    HIPACE_PROFILE("ReducedDiagnostics::WriteStep()");
+    m_active = false;
+
+    amrex::Vector<amrex::Real> moments(m_beam_moments.size());
+    amrex::Vector<amrex::Real> lineouts(m_lineouts.size());
+    amrex::Gpu::copyAsync(amrex::Gpu::deviceToHost, m_beam_moments.begin(), m_beam_moments.end(),
+                          moments.begin());
+    amrex::Gpu::copyAsync(amrex::Gpu::deviceToHost, m_lineouts.begin(), m_lineouts.end(),
+                          lineouts.begin());
+    amrex::Gpu::streamSynchronize();
+
+    // Each transverse rank holds the sums over its particles and the lineout if the center of
+    // the domain is in its box, 0 otherwise. The moments are derived from the sums over all
+    // transverse ranks.
+    amrex::ParallelReduce::Sum(moments.dataPtr(), static_cast<int>(moments.size()), 0, comm_xy);
+    amrex::ParallelReduce::Sum(lineouts.dataPtr(), static_cast<int>(lineouts.size()), 0, comm_xy);
+    if (rank_xy != 0) return;
+
+    // Each transverse rank 0 writes the time steps it computed
+    if (!amrex::UtilCreateDirectory(m_file_prefix, 0755)) {
+        amrex::CreateDirectoryFailed(m_file_prefix);
+    }
+    const std::string filename = amrex::Concatenate(m_file_prefix + "/reduced_", m_step, 6)
+                                 + ".txt";
+    std::ofstream ofs(filename);
+    if (!ofs.good()) amrex::FileOpenFailed(filename);
+
+    ofs << "# step " << m_step << " time " << physical_time << "\n";
+    ofs << "# z Ez ExmBy";
+    const amrex::Vector<std::string> beam_columns {"charge", "x_mean", "y_mean", "x_std",
+        "y_std", "emittance_x", "emittance_y", "gamma_mean", "gamma_std"};
+    for (int ibeam=0; ibeam<m_nbeams; ++ibeam) {
+        for (const auto& col : beam_columns) ofs << " " << beams.get_name(ibeam) << "_" << col;
+    }
+    ofs << "\n";
+    ofs << std::setprecision(14) << std::scientific;
+
+    const amrex::Real dz = geom.CellSize(Direction::z);
+    const amrex::Real zlo = geom.ProbLo(Direction::z);
+    // Rounding errors can make variances slightly negative
+    auto safe_sqrt = [] (const amrex::Real v) { return std::sqrt(std::max(v, amrex::Real(0.))); };
+
+    // from head to tail, in the order the slices are computed
+    for (int is=m_nslices-1; is>=0; --is) {
+        ofs << zlo + (is+0.5)*dz << " " << lineouts[is*LineoutComp::N + LineoutComp::Ez]
+            << " " << lineouts[is*LineoutComp::N + LineoutComp::ExmBy];
+        for (int ibeam=0; ibeam<m_nbeams; ++ibeam) {
+            const amrex::Real* m = moments.dataPtr() + (ibeam*m_nslices + is)*BeamMoment::N;
+            const amrex::Real sw = m[BeamMoment::w];
+            const amrex::Real inv_sw = sw != 0. ? 1./sw : 0.;
+            const amrex::Real x = m[BeamMoment::wx]*inv_sw;
+            const amrex::Real y = m[BeamMoment::wy]*inv_sw;
+            const amrex::Real ux = m[BeamMoment::wux]*inv_sw;
+            const amrex::Real uy = m[BeamMoment::wuy]*inv_sw;
+            const amrex::Real gamma = m[BeamMoment::wgamma]*inv_sw;
+            const amrex::Real xx = m[BeamMoment::wxx]*inv_sw - x*x;
+            const amrex::Real yy = m[BeamMoment::wyy]*inv_sw - y*y;
+            const amrex::Real uxux = m[BeamMoment::wuxux]*inv_sw - ux*ux;
+            const amrex::Real uyuy = m[BeamMoment::wuyuy]*inv_sw - uy*uy;
+            const amrex::Real xux = m[BeamMoment::wxux]*inv_sw - x*ux;
+            const amrex::Real yuy = m[BeamMoment::wyuy]*inv_sw - y*uy;
+            const amrex::Real gg = m[BeamMoment::wgammagamma]*inv_sw - gamma*gamma;
+            ofs << " " << beams.getBeam(ibeam).m_charge * sw << " " << x << " " << y
+                << " " << safe_sqrt(xx) << " " << safe_sqrt(yy)
+                << " " << safe_sqrt(xx*uxux - xux*xux) << " " << safe_sqrt(yy*uyuy - yuy*yuy)
+                << " " << gamma << " " << safe_sqrt(gg);
+        }
+        ofs << "\n";
+    }
+}
@@ -6,7 +6,10 @@
 #include "utils/Constants.H"
 
 Fields::Fields (Hipace const* a_hipace)
-    : m_slices(a_hipace->maxLevel()+1)
+    : m_slices(a_hipace->maxLevel()+1),
+      m_use_active_region(a_hipace->maxLevel()+1, false),
+      m_active_region(a_hipace->maxLevel()+1),
+      m_staging_area_cleared(a_hipace->maxLevel()+1, false)
 {
     amrex::ParmParse ppf("fields");
     ppf.query("do_dirichlet_poisson", m_do_dirichlet_poisson);
@@ -49,7 +52,7 @@ void
 Fields::TransverseDerivative (const amrex::MultiFab& src, amrex::MultiFab& dst, const int direction,
                               const amrex::Real dx, const amrex::Real mult_coeff,
                               const SliceOperatorType slice_operator,
-                              const int scomp, const int dcomp)
+                              const int scomp, const int dcomp, const int lev)
 {
     HIPACE_PROFILE("Fields::TransverseDerivative()");
     using namespace amrex::literals;
@@ -59,7 +62,8 @@ Fields::TransverseDerivative (const amrex::MultiFab& src, amrex::MultiFab& dst,
 #pragma omp parallel if (amrex::Gpu::notInLaunchRegion())
 #endif
     for ( amrex::MFIter mfi(dst, amrex::TilingIfNotGPU()); mfi.isValid(); ++mfi ){
-        const amrex::Box& bx = mfi.tilebox();
+        const amrex::Box bx = lev >= 0 ? ActiveBox(mfi.tilebox(), lev) : mfi.tilebox();
+        if (!bx.ok()) continue;
         amrex::Array4<amrex::Real const> const & src_array = src.array(mfi);
         amrex::Array4<amrex::Real> const & dst_array = dst.array(mfi);
         amrex::ParallelFor(
@@ -101,7 +105,8 @@ Fields::LongitudinalDerivative (const amrex::MultiFab& src1, const amrex::MultiF
                                 amrex::MultiFab& dst, const amrex::Real dz,
                                 const amrex::Real mult_coeff,
                                 const SliceOperatorType slice_operator,
-                                const int s1comp, const int s2comp, const int dcomp)
+                                const int s1comp, const int s2comp, const int dcomp,
+                                const int lev)
 {
     HIPACE_PROFILE("Fields::LongitudinalDerivative()");
     using namespace amrex::literals;
@@ -110,7 +115,8 @@ Fields::LongitudinalDerivative (const amrex::MultiFab& src1, const amrex::MultiF
 #pragma omp parallel if (amrex::Gpu::notInLaunchRegion())
 #endif
     for ( amrex::MFIter mfi(dst, amrex::TilingIfNotGPU()); mfi.isValid(); ++mfi ){
-        const amrex::Box& bx = mfi.tilebox();
+        const amrex::Box bx = lev >= 0 ? ActiveBox(mfi.tilebox(), lev) : mfi.tilebox();
+        if (!bx.ok()) continue;
         amrex::Array4<amrex::Real const> const & src1_array = src1.array(mfi);
         amrex::Array4<amrex::Real const> const & src2_array = src2.array(mfi);
         amrex::Array4<amrex::Real> const & dst_array = dst.array(mfi);
@@ -134,10 +140,62 @@ Fields::LongitudinalDerivative (const amrex::MultiFab& src1, const amrex::MultiF
     }
 }
 
+void
+Fields::SetActiveRegion (const int lev, const amrex::Box& region)
+{
+    m_use_active_region[lev] = true;
+    m_active_region[lev] = region;
+}
+
+amrex::Box
+Fields::ActiveBox (const amrex::Box& bx, const int lev) const
+{
+    if (!m_use_active_region[lev]) return bx;
+    amrex::Box active_bx = bx;
+    for (int idim = 0; idim < Direction::z; ++idim) {
+        active_bx.setSmall(idim, std::max(bx.smallEnd(idim),
+                                          m_active_region[lev].smallEnd(idim)));
+        active_bx.setBig(idim, std::min(bx.bigEnd(idim), m_active_region[lev].bigEnd(idim)));
+    }
+    return active_bx;
+}
+
+bool
+Fields::ActiveRegionIsInterior (const int lev)
+{
+    if (!m_use_active_region[lev]) return false;
+    // with several boxes, the guard cells are exchanged between ranks
+    if (getSlices(lev, WhichSlice::This).boxArray().size() != 1) return false;
+    // the transverse derivatives read one cell around the active region
+    amrex::Box region = m_active_region[lev];
+    region.grow({1, 1, 0});
+    for (amrex::MFIter mfi(getSlices(lev, WhichSlice::This)); mfi.isValid(); ++mfi) {
+        const amrex::Box& vbx = mfi.validbox();
+        for (int idim = 0; idim < Direction::z; ++idim) {
+            if (region.smallEnd(idim) < vbx.smallEnd(idim) ||
+                region.bigEnd(idim) > vbx.bigEnd(idim)) return false;
+        }
+    }
+    return true;
+}
+
+void
+Fields::PrepareStagingArea (const int lev)
+{
+    // The solver writes its result to the whole staging area. It is zeroed once, then the
+    // solver zeroes it while copying the solution out, so the staging area is already zero
+    // outside of the active region without an extra sweep over the slice.
+    if (m_use_active_region[lev] && !m_staging_area_cleared[lev]) {
+        m_poisson_solver[lev]->StagingArea().setVal(0.);
+        m_poisson_solver[lev]->ClearStagingAreaAfterSolve(true);
+        m_staging_area_cleared[lev] = true;
+    }
+}
 
 void
 Fields::Copy (int lev, int i_slice, FieldCopyType copy_type, int slice_comp, int full_comp,
-              int ncomp, amrex::FArrayBox& fab, int slice_dir, amrex::Geometry geom)
+              int ncomp, amrex::FArrayBox& fab, int slice_dir, amrex::Geometry geom,
+              const amrex::IntVect diag_coarsen)
 {
     using namespace amrex::literals;
     HIPACE_PROFILE("Fields::Copy()");
@@ -153,6 +211,50 @@ Fields::Copy (int lev, int i_slice, FieldCopyType copy_type, int slice_comp, int
     }
 
     amrex::Box const& vbx = fab.box();
+
+    if (copy_type == FieldCopyType::StoF && diag_coarsen != amrex::IntVect(1)) {
+        // fab is coarsened: add the average of this slice over the fine cells of each coarse
+        // cell, weighted by the fraction of the coarse cell in z covered by one slice.
+        const int k_coarse = amrex::coarsen(i_slice, diag_coarsen[Direction::z]);
+        if (vbx.smallEnd(Direction::z) > k_coarse || vbx.bigEnd(Direction::z) < k_coarse) return;
+
+        amrex::Box copy_box = vbx;
+        copy_box.setSmall(Direction::z, k_coarse);
+        copy_box.setBig  (Direction::z, k_coarse);
+
+        amrex::Array4<amrex::Real> const& full_array = fab.array();
+
+        const amrex::IntVect ncells_global = geom.Domain().length();
+        const bool nx_even = ncells_global[0] % 2 == 0;
+        const bool ny_even = ncells_global[1] % 2 == 0;
+        const int crx = diag_coarsen[0];
+        const int cry = diag_coarsen[1];
+        const amrex::Real inv_ncells = 1._rt / (diag_coarsen[0]*diag_coarsen[1]*diag_coarsen[2]);
+
+        amrex::ParallelFor(copy_box, ncomp,
+        [=] AMREX_GPU_DEVICE (int i, int j, int k, int n) noexcept
+        {
+            amrex::Real sum = 0._rt;
+            for (int jj = j*cry; jj < (j+1)*cry; ++jj) {
+                for (int ii = i*crx; ii < (i+1)*crx; ++ii) {
+                    if        (slice_dir ==-1 /* 3D data */){
+                        sum += slice_array(ii,jj,i_slice,n+slice_comp);
+                    } else if (slice_dir == 0 /* yz slice */){
+                        sum += nx_even ? 0.5_rt * (slice_array(ii-1,jj,i_slice,n+slice_comp) +
+                                                   slice_array(ii,jj,i_slice,n+slice_comp))
+                            : slice_array(ii,jj,i_slice,n+slice_comp);
+                    } else /* slice_dir == 1, xz slice */{
+                        sum += ny_even ? 0.5_rt * (slice_array(ii,jj-1,i_slice,n+slice_comp) +
+                                                   slice_array(ii,jj,i_slice,n+slice_comp))
+                            : slice_array(ii,jj,i_slice,n+slice_comp);
+                    }
+                }
+            }
+            full_array(i,j,k,n+full_comp) += sum * inv_ncells;
+        });
+        return;
+    }
+
     if (vbx.smallEnd(Direction::z) <= i_slice and
         vbx.bigEnd  (Direction::z) >= i_slice)
     {
@@ -231,13 +333,30 @@ Fields::AddBeamCurrents (const int lev, const int which_slice)
     HIPACE_PROFILE("Fields::AddBeamCurrents()");
     amrex::MultiFab& S = getSlices(lev, which_slice);
     // we add the beam currents to the full currents, as mostly the full currents are needed
-    amrex::MultiFab::Add(S, S, Comps[which_slice]["jx_beam"], Comps[which_slice]["jx"], 1,
-                         {Hipace::m_depos_order_xy, Hipace::m_depos_order_xy, 0});
-    amrex::MultiFab::Add(S, S, Comps[which_slice]["jy_beam"], Comps[which_slice]["jy"], 1,
-                         {Hipace::m_depos_order_xy, Hipace::m_depos_order_xy, 0});
-    if (which_slice == WhichSlice::This) {
-        amrex::MultiFab::Add(S, S, Comps[which_slice]["jz_beam"], Comps[which_slice]["jz"], 1,
-                             {Hipace::m_depos_order_xy, Hipace::m_depos_order_xy, 0});
+    const int ijx = Comps[which_slice]["jx"];
+    const int ijx_beam = Comps[which_slice]["jx_beam"];
+    const int ijy = Comps[which_slice]["jy"];
+    const int ijy_beam = Comps[which_slice]["jy_beam"];
+    const bool do_jz = which_slice == WhichSlice::This;
+    const int ijz = do_jz ? Comps[which_slice]["jz"] : 0;
+    const int ijz_beam = do_jz ? Comps[which_slice]["jz_beam"] : 0;
+#ifdef AMREX_USE_OMP
+#pragma omp parallel if (amrex::Gpu::notInLaunchRegion())
+#endif
+    for ( amrex::MFIter mfi(S, amrex::TilingIfNotGPU()); mfi.isValid(); ++mfi ){
+        // the beam only deposits in the active region, which includes the guard cells it
+        // deposits to
+        const amrex::Box bx = ActiveBox(
+            mfi.growntilebox({Hipace::m_depos_order_xy, Hipace::m_depos_order_xy, 0}), lev);
+        if (!bx.ok()) continue;
+        amrex::Array4<amrex::Real> const & arr = S.array(mfi);
+        amrex::ParallelFor(bx,
+            [=] AMREX_GPU_DEVICE(int i, int j, int k) noexcept
+            {
+                arr(i,j,k,ijx) += arr(i,j,k,ijx_beam);
+                arr(i,j,k,ijy) += arr(i,j,k,ijy_beam);
+                if (do_jz) arr(i,j,k,ijz) += arr(i,j,k,ijz_beam);
+            });
     }
 }
 
@@ -337,12 +456,27 @@ Fields::SolvePoissonExmByAndEypBx (amrex::Vector<amrex::Geometry> const& geom,
                         Comps[WhichSlice::This]["Psi"], 1);
 
     // calculating the right-hand side 1/episilon0 * -(rho-Jz/c)
-    amrex::MultiFab::Copy(m_poisson_solver[lev]->StagingArea(), getSlices(lev, WhichSlice::This),
-                              Comps[WhichSlice::This]["jz"], 0, 1, 0);
-    m_poisson_solver[lev]->StagingArea().mult(-1./phys_const.c);
-    amrex::MultiFab::Add(m_poisson_solver[lev]->StagingArea(), getSlices(lev, WhichSlice::This),
-                          Comps[WhichSlice::This]["rho"], 0, 1, 0);
-    m_poisson_solver[lev]->StagingArea().mult(-1./phys_const.ep0);
+    PrepareStagingArea(lev);
+    amrex::MultiFab& staging_area = m_poisson_solver[lev]->StagingArea();
+    const int ijz = Comps[WhichSlice::This]["jz"];
+    const int irho = Comps[WhichSlice::This]["rho"];
+    const amrex::Real mult_jz = -1./phys_const.c;
+    const amrex::Real mult_rhs = -1./phys_const.ep0;
+#ifdef AMREX_USE_OMP
+#pragma omp parallel if (amrex::Gpu::notInLaunchRegion())
+#endif
+    for ( amrex::MFIter mfi(staging_area, amrex::TilingIfNotGPU()); mfi.isValid(); ++mfi ){
+        const amrex::Box bx = ActiveBox(mfi.tilebox(), lev);
+        if (!bx.ok()) continue;
+        amrex::Array4<amrex::Real const> const & slice_arr =
+            getSlices(lev, WhichSlice::This).const_array(mfi);
+        amrex::Array4<amrex::Real> const & rhs_arr = staging_area.array(mfi);
+        amrex::ParallelFor(bx,
+            [=] AMREX_GPU_DEVICE(int i, int j, int k) noexcept
+            {
+                rhs_arr(i,j,k) = (slice_arr(i,j,k,ijz)*mult_jz + slice_arr(i,j,k,irho))*mult_rhs;
+            });
+    }
 
     InterpolateBoundaries( geom, lev, "Psi");
     m_poisson_solver[lev]->SolvePoissonEquation(lhs);
@@ -387,6 +521,7 @@ Fields::SolvePoissonEz (amrex::Vector<amrex::Geometry> const& geom, const int le
                         Comps[WhichSlice::This]["Ez"], 1);
     // Right-Hand Side for Poisson equation: compute 1/(episilon0 *c0 )*(d_x(jx) + d_y(jy))
     // from the slice MF, and store in the staging area of poisson_solver
+    PrepareStagingArea(lev);
     TransverseDerivative(
         getSlices(lev, WhichSlice::This),
         m_poisson_solver[lev]->StagingArea(),
@@ -394,7 +529,7 @@ Fields::SolvePoissonEz (amrex::Vector<amrex::Geometry> const& geom, const int le
         geom[lev].CellSize(Direction::x),
         1./(phys_const.ep0*phys_const.c),
         SliceOperatorType::Assign,
-        Comps[WhichSlice::This]["jx"]);
+        Comps[WhichSlice::This]["jx"], 0, lev);
 
     TransverseDerivative(
         getSlices(lev, WhichSlice::This),
@@ -403,7 +538,7 @@ Fields::SolvePoissonEz (amrex::Vector<amrex::Geometry> const& geom, const int le
         geom[lev].CellSize(Direction::y),
         1./(phys_const.ep0*phys_const.c),
         SliceOperatorType::Add,
-        Comps[WhichSlice::This]["jy"]);
+        Comps[WhichSlice::This]["jy"], 0, lev);
     //Interpolation
     InterpolateBoundaries( geom, lev, "Ez");
     // Solve Poisson equation.
@@ -423,6 +558,7 @@ Fields::SolvePoissonBx (amrex::MultiFab& Bx_iter, amrex::Vector<amrex::Geometry>
     PhysConst phys_const = get_phys_const();
     // Right-Hand Side for Poisson equation: compute -mu_0*d_y(jz) from the slice MF,
     // and store in the staging area of poisson_solver
+    PrepareStagingArea(lev);
     TransverseDerivative(
         getSlices(lev, WhichSlice::This),
         m_poisson_solver[lev]->StagingArea(),
@@ -430,7 +566,7 @@ Fields::SolvePoissonBx (amrex::MultiFab& Bx_iter, amrex::Vector<amrex::Geometry>
         geom[lev].CellSize(Direction::y),
         -phys_const.mu0,
         SliceOperatorType::Assign,
-        Comps[WhichSlice::This]["jz"]);
+        Comps[WhichSlice::This]["jz"], 0, lev);
 
     LongitudinalDerivative(
         getSlices(lev, WhichSlice::Previous1),
@@ -440,7 +576,7 @@ Fields::SolvePoissonBx (amrex::MultiFab& Bx_iter, amrex::Vector<amrex::Geometry>
         phys_const.mu0,
         SliceOperatorType::Add,
         Comps[WhichSlice::Previous1]["jy"],
-        Comps[WhichSlice::Next]["jy"]);
+        Comps[WhichSlice::Next]["jy"], 0, lev);
     //Interpolation
     InterpolateBoundaries( geom, lev, "Bx");
     // Solve Poisson equation.
@@ -459,6 +595,7 @@ Fields::SolvePoissonBy (amrex::MultiFab& By_iter, amrex::Vector<amrex::Geometry>
     PhysConst phys_const = get_phys_const();
     // Right-Hand Side for Poisson equation: compute mu_0*d_x(jz) from the slice MF,
     // and store in the staging area of poisson_solver
+    PrepareStagingArea(lev);
     TransverseDerivative(
         getSlices(lev, WhichSlice::This),
         m_poisson_solver[lev]->StagingArea(),
@@ -466,7 +603,7 @@ Fields::SolvePoissonBy (amrex::MultiFab& By_iter, amrex::Vector<amrex::Geometry>
         geom[lev].CellSize(Direction::x),
         phys_const.mu0,
         SliceOperatorType::Assign,
-        Comps[WhichSlice::This]["jz"]);
+        Comps[WhichSlice::This]["jz"], 0, lev);
 
     LongitudinalDerivative(
         getSlices(lev, WhichSlice::Previous1),
@@ -476,7 +613,7 @@ Fields::SolvePoissonBy (amrex::MultiFab& By_iter, amrex::Vector<amrex::Geometry>
         -phys_const.mu0,
         SliceOperatorType::Add,
         Comps[WhichSlice::Previous1]["jx"],
-        Comps[WhichSlice::Next]["jx"]);
+        Comps[WhichSlice::Next]["jx"], 0, lev);
     //Interpolation
     InterpolateBoundaries( geom, lev, "By");
     // Solve Poisson equation.
@@ -497,6 +634,7 @@ Fields::SolvePoissonBz (amrex::Vector<amrex::Geometry> const& geom, const int le
                         Comps[WhichSlice::This]["Bz"], 1);
     // Right-Hand Side for Poisson equation: compute mu_0*(d_y(jx) - d_x(jy))
     // from the slice MF, and store in the staging area of m_poisson_solver
+    PrepareStagingArea(lev);
     TransverseDerivative(
         getSlices(lev, WhichSlice::This),
         m_poisson_solver[lev]->StagingArea(),
@@ -504,7 +642,7 @@ Fields::SolvePoissonBz (amrex::Vector<amrex::Geometry> const& geom, const int le
         geom[lev].CellSize(Direction::y),
         phys_const.mu0,
         SliceOperatorType::Assign,
-        Comps[WhichSlice::This]["jx"]);
+        Comps[WhichSlice::This]["jx"], 0, lev);
 
     TransverseDerivative(
         getSlices(lev, WhichSlice::This),
@@ -513,7 +651,7 @@ Fields::SolvePoissonBz (amrex::Vector<amrex::Geometry> const& geom, const int le
         geom[lev].CellSize(Direction::x),
         -phys_const.mu0,
         SliceOperatorType::Add,
-        Comps[WhichSlice::This]["jy"]);
+        Comps[WhichSlice::This]["jy"], 0, lev);
     //Interpolation
     InterpolateBoundaries( geom, lev, "Bz");
     // Solve Poisson equation.
@@ -600,7 +738,7 @@ amrex::Real
 Fields::ComputeRelBFieldError (
     const amrex::MultiFab& Bx, const amrex::MultiFab& By, const amrex::MultiFab& Bx_iter,
     const amrex::MultiFab& By_iter, const int Bx_comp, const int By_comp, const int Bx_iter_comp,
-    const int By_iter_comp, const amrex::Geometry& geom)
+    const int By_iter_comp, const amrex::Geometry& geom, const int lev)
 {
     // calculates the relative B field error between two B fields
     // for both Bx and By simultaneously
@@ -615,7 +753,8 @@ Fields::ComputeRelBFieldError (
     amrex::Real* p_norm_B = gpu_norm_B.dataPtr();
 
     for ( amrex::MFIter mfi(Bx, amrex::TilingIfNotGPU()); mfi.isValid(); ++mfi ){
-        const amrex::Box& bx = mfi.tilebox();
+        const amrex::Box bx = ActiveBox(mfi.tilebox(), lev);
+        if (!bx.ok()) continue;
         amrex::Array4<amrex::Real const> const & Bx_array = Bx.array(mfi);
         amrex::Array4<amrex::Real const> const & Bx_iter_array = Bx_iter.array(mfi);
         amrex::Array4<amrex::Real const> const & By_array = By.array(mfi);
@@ -641,7 +780,9 @@ Fields::ComputeRelBFieldError (
     norm_Bdiff = gpu_norm_Bdiff.dataValue();
     norm_B = gpu_norm_B.dataValue();
 
-    const int numPts_transverse = geom.Domain().length(0) * geom.Domain().length(1);
+    const amrex::Box active_domain = ActiveBox(geom.Domain(), lev);
+    const int numPts_transverse = active_domain.ok() ?
+        active_domain.length(0) * active_domain.length(1) : 1;
 
     // calculating the relative error
     // Warning: this test might be not working in SI units!
@@ -1,6 +1,7 @@
 #include "FFTPoissonSolverDirichlet.H"
 #include "utils/Constants.H"
 #include "utils/HipaceProfilerWrapper.H"
+#include "utils/MemoryReport.H"
 
 FFTPoissonSolverDirichlet::FFTPoissonSolverDirichlet (
     amrex::BoxArray const& realspace_ba,
@@ -100,6 +101,7 @@ void
 FFTPoissonSolverDirichlet::SolvePoissonEquation (amrex::MultiFab& lhs_mf)
 {
     HIPACE_PROFILE("FFTPoissonSolverDirichlet::SolvePoissonEquation()");
+    ++m_num_solves;
 
     // Loop over boxes
     for ( amrex::MFIter mfi(m_stagingArea); mfi.isValid(); ++mfi ){
@@ -123,10 +125,26 @@ FFTPoissonSolverDirichlet::SolvePoissonEquation (amrex::MultiFab& lhs_mf)
         // Copy from the staging area to output array (and normalize)
         amrex::Array4<amrex::Real> tmp_real_arr = m_stagingArea.array(mfi);
         amrex::Array4<amrex::Real> lhs_arr = lhs_mf.array(mfi);
+        const bool clear = m_clear_staging_area;
         amrex::ParallelFor( mfi.validbox(),
             [=] AMREX_GPU_DEVICE(int i, int j, int k) noexcept {
                 // Copy and normalize field
                 lhs_arr(i,j,k) = tmp_real_arr(i,j,k);
+                if (clear) tmp_real_arr(i,j,k) = 0.;
             });
     }
 }
+
+amrex::Long
+FFTPoissonSolverDirichlet::SpectralBytes () const
+{
+    amrex::Long bytes = MemoryReport::Bytes(m_tmpSpectralField)
+                        + MemoryReport::Bytes(m_eigenvalue_matrix);
+    // expanded arrays of the DST, only allocated with Cuda
+    for (amrex::MFIter mfi(m_stagingArea); mfi.isValid(); ++mfi) {
+        const AnyDST::DSTplan& plan = m_plan[mfi];
+        if (plan.m_expanded_position_array) bytes += plan.m_expanded_position_array->nBytes();
+        if (plan.m_expanded_fourier_array) bytes += plan.m_expanded_fourier_array->nBytes();
+    }
+    return bytes;
+}
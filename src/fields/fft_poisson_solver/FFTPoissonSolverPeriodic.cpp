@@ -1,6 +1,7 @@
 #include "FFTPoissonSolverPeriodic.H"
 #include "utils/Constants.H"
 #include "utils/HipaceProfilerWrapper.H"
+#include "utils/MemoryReport.H"
 
 FFTPoissonSolverPeriodic::FFTPoissonSolverPeriodic (
     amrex::BoxArray const& realspace_ba,
@@ -107,6 +108,7 @@ void
 FFTPoissonSolverPeriodic::SolvePoissonEquation (amrex::MultiFab& lhs_mf)
 {
     HIPACE_PROFILE("FFTPoissonSolverPeriodic::SolvePoissonEquation()");
+    ++m_num_solves;
 
     // Loop over boxes
     for ( amrex::MFIter mfi(m_stagingArea); mfi.isValid(); ++mfi ){
@@ -130,11 +132,19 @@ FFTPoissonSolverPeriodic::SolvePoissonEquation (amrex::MultiFab& lhs_mf)
         amrex::Array4<amrex::Real> tmp_real_arr = m_stagingArea.array(mfi);
         amrex::Array4<amrex::Real> lhs_arr = lhs_mf.array(mfi);
         const amrex::Real inv_N = 1./mfi.validbox().numPts();
+        const bool clear = m_clear_staging_area;
         amrex::ParallelFor( mfi.validbox(),
             [=] AMREX_GPU_DEVICE(int i, int j, int k) noexcept {
                 // Copy and normalize field
                 lhs_arr(i,j,k) = inv_N*tmp_real_arr(i,j,k);
+                if (clear) tmp_real_arr(i,j,k) = 0.;
             });
 
     }
 }
+
+amrex::Long
+FFTPoissonSolverPeriodic::SpectralBytes () const
+{
+    return MemoryReport::Bytes(m_tmpSpectralField) + MemoryReport::Bytes(m_inv_k2);
+}
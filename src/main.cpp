@@ -1,6 +1,8 @@
 
 #include "Hipace.H"
+#include "utils/BenchmarkMode.H"
 #include "utils/HipaceProfilerWrapper.H"
+#include "utils/HipaceTracer.H"
 
 #include <AMReX.H>
 
@@ -9,10 +11,12 @@ int main (int argc, char* argv[])
     amrex::Initialize(argc,argv);
     HIPACE_PROFILE_VAR("main()", pmain);
     {
+        BenchmarkMode::Setup();
         Hipace hipace;
         hipace.InitData();
         hipace.Evolve();
     }
+    HipaceTracer::WriteTrace();
     HIPACE_PROFILE_VAR_STOP(pmain);
     amrex::Finalize();
 }
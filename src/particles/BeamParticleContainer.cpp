@@ -54,6 +54,21 @@ BeamParticleContainer::ReadParameters ()
     pp.query("n_subcycles", m_n_subcycles);
     pp.query("finest_level", m_finest_level);
     AMREX_ALWAYS_ASSERT_WITH_MESSAGE( m_n_subcycles >= 1, "n_subcycles must be >= 1");
+    pp.query("adaptive_subcycling", m_adaptive_subcycling);
+    pp.query("subcycling_phase_advance", m_subcycling_phase_advance);
+    AMREX_ALWAYS_ASSERT_WITH_MESSAGE( m_subcycling_phase_advance > 0.,
+                                      "subcycling_phase_advance must be > 0");
+    pp.query("output_fraction", m_output_filter.m_fraction);
+    AMREX_ALWAYS_ASSERT_WITH_MESSAGE( m_output_filter.m_fraction > 0. &&
+                                      m_output_filter.m_fraction <= 1.,
+                                      "output_fraction must be in (0, 1]");
+    pp.query("output_zmin", m_output_filter.m_zmin);
+    pp.query("output_zmax", m_output_filter.m_zmax);
+    pp.query("output_uz_min", m_output_filter.m_uz_min);
+    pp.query("output_uz_max", m_output_filter.m_uz_max);
+    pp.query("output_id_stride", m_output_filter.m_id_stride);
+    AMREX_ALWAYS_ASSERT_WITH_MESSAGE( m_output_filter.m_id_stride >= 1,
+                                      "output_id_stride must be >= 1");
     if (m_injection_type == "fixed_ppc" || m_injection_type == "from_file"){
         AMREX_ALWAYS_ASSERT_WITH_MESSAGE( (m_dx_per_dzeta == 0.) && (m_dy_per_dzeta == 0.)
                                            && (m_duz_per_uz0_dzeta == 0.),
@@ -121,6 +136,9 @@ BeamParticleContainer::InitData (const amrex::Geometry& geom)
         bool coordinates_specified = pp.query("file_coordinates_xyz", m_file_coordinates_xyz);
         bool n_0_specified = pp.query("plasma_density", m_plasma_density);
         pp.query("iteration", m_num_iteration);
+        pp.query("file_read_batch_size", m_file_read_batch_size);
+        AMREX_ALWAYS_ASSERT_WITH_MESSAGE(m_file_read_batch_size > 0,
+                                         "file_read_batch_size must be > 0");
         bool species_specified = pp.query("openPMD_species_name", m_species_name);
         if(!species_specified) {
             m_species_name = m_name;
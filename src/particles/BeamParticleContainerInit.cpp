@@ -3,7 +3,12 @@
 #include "ParticleUtil.H"
 #include "Hipace.H"
 #include "utils/HipaceProfilerWrapper.H"
+#include "utils/CounterRNG.H"
 #include <AMReX_REAL.H>
+#include <AMReX_ParmParse.H>
+
+#include <algorithm>
+#include <cstdint>
 
 #ifdef HIPACE_USE_OPENPMD
 #include <openPMD/openPMD.hpp>
@@ -53,6 +58,154 @@ namespace
         arrdata[BeamIdx::uz  ][ip] = uz * speed_of_light;
         arrdata[BeamIdx::w][ip] = weight;
     }
+
+    /** \brief Returns the seed of the counter-based RNG of a beam, obtained by hashing the
+     * beam name together with the global input parameter random_seed (default 0)
+     *
+     * \param[in] name name of the beam
+     */
+    std::uint64_t GetBeamSeed (const std::string& name)
+    {
+        amrex::ParmParse pp;
+        int random_seed = 0;
+        pp.query("random_seed", random_seed);
+        std::uint64_t seed = CounterRNG::mix(static_cast<std::uint64_t>(random_seed));
+        for (const char c : name) {
+            seed = CounterRNG::mix(seed ^ static_cast<unsigned char>(c));
+        }
+        return seed;
+    }
+
+    /** \brief Returns the index of the first particle of this rank in the global particle
+     * ordering, when each rank created num_local particles in rank order
+     *
+     * \param[in] num_local number of particles created on this rank
+     * \param[out] num_total number of particles created on all ranks
+     */
+    int GlobalParticleOffset (const int num_local, int& num_total)
+    {
+        int offset = 0;
+        num_total = num_local;
+#ifdef AMREX_USE_MPI
+        MPI_Exscan(&num_local, &offset, 1, amrex::ParallelDescriptor::Mpi_typemap<int>::type(),
+                   MPI_SUM, amrex::ParallelDescriptor::Communicator());
+        if (amrex::ParallelDescriptor::MyProc() == 0) offset = 0;
+        amrex::ParallelDescriptor::ReduceIntSum(num_total);
+#endif
+        return offset;
+    }
+
+    /** \brief Moves the beam particles generated on all ranks to the head rank, in rank order.
+     * The pipeline expects the whole beam on the head rank at the start of the simulation: each
+     * rank computes whole time steps, and the head rank computes the first one for all boxes.
+     * Keeping the beam distributed would require a different initialization of the pipeline, so
+     * the head rank deliberately holds the whole beam after this call, as for a beam generated
+     * on a single rank. Only the generation or the read is parallel. The head rank receives one
+     * rank at a time, so its host staging memory is bounded by the largest share of one rank.
+     *
+     * \param[in,out] beam beam particles of this rank, empty on output except on the head rank
+     */
+    void GatherBeamOnHeadRank (BeamParticleContainer& beam)
+    {
+#ifdef AMREX_USE_MPI
+        const int nprocs = amrex::ParallelDescriptor::NProcs();
+        if (nprocs == 1) return;
+        HIPACE_PROFILE("GatherBeamOnHeadRank()");
+
+        using ParticleType = BeamParticleContainer::ParticleType;
+        const int myproc = amrex::ParallelDescriptor::MyProc();
+        const int head = nprocs - 1;
+        MPI_Comm comm = amrex::ParallelDescriptor::Communicator();
+        constexpr int aos_tag = 1101;
+        constexpr int soa_tag = 1102;
+
+        const int np_loc = beam.numParticles();
+        amrex::Vector<int> np_all(nprocs, 0);
+        MPI_Gather(&np_loc, 1, amrex::ParallelDescriptor::Mpi_typemap<int>::type(),
+                   np_all.dataPtr(), 1, amrex::ParallelDescriptor::Mpi_typemap<int>::type(),
+                   head, comm);
+
+        // AoS is sent as raw bytes
+        MPI_Datatype ptype;
+        MPI_Type_contiguous(sizeof(ParticleType), MPI_BYTE, &ptype);
+        MPI_Type_commit(&ptype);
+        const auto rtype = amrex::ParallelDescriptor::Mpi_typemap<amrex::ParticleReal>::type();
+
+        amrex::Vector<ParticleType> aos_buf;
+        amrex::Vector<amrex::ParticleReal> soa_buf;
+
+        if (myproc != head) {
+            if (np_loc > 0) {
+                auto& aos = beam.GetArrayOfStructs()();
+                aos_buf.resize(np_loc);
+                amrex::Gpu::copyAsync(amrex::Gpu::deviceToHost, aos.begin(), aos.end(),
+                                      aos_buf.begin());
+                amrex::Gpu::streamSynchronize();
+                MPI_Send(aos_buf.dataPtr(), np_loc, ptype, head, aos_tag, comm);
+                aos_buf.clear();
+                soa_buf.resize(np_loc);
+                for (int comp=0; comp<BeamIdx::nattribs; ++comp) {
+                    auto& rdata = beam.GetStructOfArrays().GetRealData(comp);
+                    amrex::Gpu::copyAsync(amrex::Gpu::deviceToHost, rdata.begin(), rdata.end(),
+                                          soa_buf.begin());
+                    amrex::Gpu::streamSynchronize();
+                    MPI_Send(soa_buf.dataPtr(), np_loc, rtype, head, soa_tag, comm);
+                }
+            }
+            beam.resize(0);
+        } else {
+            int np_total = 0;
+            for (int r=0; r<nprocs; ++r) np_total += np_all[r];
+            // The particles of the head rank go last
+            const int head_offset = np_total - np_loc;
+            beam.resize(np_total);
+            auto& aos = beam.GetArrayOfStructs()();
+            if (np_loc > 0 && head_offset > 0) {
+                // Move own particles to the end, through a host copy since source and
+                // destination can overlap.
+                aos_buf.resize(np_loc);
+                amrex::Gpu::copyAsync(amrex::Gpu::deviceToHost, aos.begin(),
+                                      aos.begin() + np_loc, aos_buf.begin());
+                amrex::Gpu::streamSynchronize();
+                amrex::Gpu::copyAsync(amrex::Gpu::hostToDevice, aos_buf.begin(), aos_buf.end(),
+                                      aos.begin() + head_offset);
+                soa_buf.resize(np_loc);
+                for (int comp=0; comp<BeamIdx::nattribs; ++comp) {
+                    auto& rdata = beam.GetStructOfArrays().GetRealData(comp);
+                    amrex::Gpu::copyAsync(amrex::Gpu::deviceToHost, rdata.begin(),
+                                          rdata.begin() + np_loc, soa_buf.begin());
+                    amrex::Gpu::streamSynchronize();
+                    amrex::Gpu::copyAsync(amrex::Gpu::hostToDevice, soa_buf.begin(),
+                                          soa_buf.end(), rdata.begin() + head_offset);
+                }
+                amrex::Gpu::streamSynchronize();
+            }
+            int offset = 0;
+            for (int r=0; r<head; ++r) {
+                const int np = np_all[r];
+                if (np == 0) continue;
+                MPI_Status status;
+                aos_buf.resize(np);
+                MPI_Recv(aos_buf.dataPtr(), np, ptype, r, aos_tag, comm, &status);
+                amrex::Gpu::copyAsync(amrex::Gpu::hostToDevice, aos_buf.begin(), aos_buf.end(),
+                                      aos.begin() + offset);
+                amrex::Gpu::streamSynchronize();
+                soa_buf.resize(np);
+                for (int comp=0; comp<BeamIdx::nattribs; ++comp) {
+                    auto& rdata = beam.GetStructOfArrays().GetRealData(comp);
+                    MPI_Recv(soa_buf.dataPtr(), np, rtype, r, soa_tag, comm, &status);
+                    amrex::Gpu::copyAsync(amrex::Gpu::hostToDevice, soa_buf.begin(),
+                                          soa_buf.end(), rdata.begin() + offset);
+                    amrex::Gpu::streamSynchronize();
+                }
+                offset += np;
+            }
+        }
+        MPI_Type_free(&ptype);
+#else
+        amrex::ignore_unused(beam);
+#endif
+    }
 }
 
 void
@@ -68,8 +221,6 @@ InitBeamFixedPPC (const amrex::IntVect& a_num_particles_per_cell,
 {
     HIPACE_PROFILE("BeamParticleContainer::InitParticles");
 
-    if (!Hipace::HeadRank()) { return; }
-
     const amrex::IntVect ncells = a_geom.Domain().length();
     amrex::Long ncells_total = (amrex::Long) ncells[0] * ncells[1] * ncells[2];
     if ( ncells_total / Hipace::m_beam_injection_cr / Hipace::m_beam_injection_cr
@@ -96,61 +247,84 @@ InitBeamFixedPPC (const amrex::IntVect& a_num_particles_per_cell,
     const amrex::Real scale_fac = Hipace::m_normalized_units ?
         1./num_ppc*cr[0]*cr[1]*cr[2] : dx[0]*dx[1]*dx[2]/num_ppc;
 
-    // First: loop over all cells, and count the particles effectively injected.
     amrex::Box domain_box = a_geom.Domain();
     domain_box.coarsen(cr);
     const auto lo = amrex::lbound(domain_box);
     const auto hi = amrex::ubound(domain_box);
 
-    amrex::Gpu::DeviceVector<unsigned int> counts(domain_box.numPts(), 0);
+    // Each rank injects the particles of a slab of cells in x, which is the slowest index of
+    // the cell ordering below. Gathering the slabs in rank order then gives the same particle
+    // order for any number of ranks. The random numbers only depend on the global cell index.
+    const int nprocs = amrex::ParallelDescriptor::NProcs();
+    const int myproc = amrex::ParallelDescriptor::MyProc();
+    amrex::Box local_box = domain_box;
+    const amrex::Long nx_domain = domain_box.length(0);
+    local_box.setSmall(0, lo.x + static_cast<int>(nx_domain*myproc/nprocs));
+    local_box.setBig(0, lo.x + static_cast<int>(nx_domain*(myproc+1)/nprocs) - 1);
+
+    // First: loop over all cells, and count the particles effectively injected.
+    const int num_local_cells = local_box.ok() ? static_cast<int>(local_box.numPts()) : 0;
+    amrex::Gpu::DeviceVector<unsigned int> counts(num_local_cells, 0);
     unsigned int* pcount = counts.dataPtr();
 
-    amrex::Gpu::DeviceVector<unsigned int> offsets(domain_box.numPts());
+    amrex::Gpu::DeviceVector<unsigned int> offsets(num_local_cells);
     unsigned int* poffset = offsets.dataPtr();
 
-    amrex::ParallelFor(domain_box,
-        [=] AMREX_GPU_DEVICE (int i, int j, int k) noexcept
-        {
-            for (int i_part=0; i_part<num_ppc;i_part++)
-            {
-                amrex::Real r[3];
-
-                ParticleUtil::get_position_unit_cell(r, ppc_cr, i_part);
+    const auto local_lo = amrex::lbound(local_box);
+    const auto local_hi = amrex::ubound(local_box);
 
-                amrex::Real x = plo[0] + (i + r[0])*dx[0];
-                amrex::Real y = plo[1] + (j + r[1])*dx[1];
-                amrex::Real z = plo[2] + (k + r[2])*dx[2];
-
-                if (z >= a_zmax || z < a_zmin ||
-                    (x*x+y*y) > a_radius*a_radius) continue;
-
-                const amrex::Real density = get_density(x, y, z);
-                if (density < a_min_density) continue;
+    if (num_local_cells > 0) {
+        amrex::ParallelFor(local_box,
+            [=] AMREX_GPU_DEVICE (int i, int j, int k) noexcept
+            {
+                for (int i_part=0; i_part<num_ppc;i_part++)
+                {
+                    amrex::Real r[3];
+
+                    ParticleUtil::get_position_unit_cell(r, ppc_cr, i_part);
+
+                    amrex::Real x = plo[0] + (i + r[0])*dx[0];
+                    amrex::Real y = plo[1] + (j + r[1])*dx[1];
+                    amrex::Real z = plo[2] + (k + r[2])*dx[2];
+
+                    if (z >= a_zmax || z < a_zmin ||
+                        (x*x+y*y) > a_radius*a_radius) continue;
+
+                    const amrex::Real density = get_density(x, y, z);
+                    if (density < a_min_density) continue;
+
+                    int ix = i - local_lo.x;
+                    int iy = j - local_lo.y;
+                    int iz = k - local_lo.z;
+                    int nx = local_hi.x-local_lo.x+1;
+                    int ny = local_hi.y-local_lo.y+1;
+                    int nz = local_hi.z-local_lo.z+1;
+                    unsigned int uix = amrex::min(nx-1,amrex::max(0,ix));
+                    unsigned int uiy = amrex::min(ny-1,amrex::max(0,iy));
+                    unsigned int uiz = amrex::min(nz-1,amrex::max(0,iz));
+                    unsigned int cellid = (uix * ny + uiy) * nz + uiz;
+                    pcount[cellid] += 1;
+                }
+            });
+    }
 
-                int ix = i - lo.x;
-                int iy = j - lo.y;
-                int iz = k - lo.z;
-                int nx = hi.x-lo.x+1;
-                int ny = hi.y-lo.y+1;
-                int nz = hi.z-lo.z+1;
-                unsigned int uix = amrex::min(nx-1,amrex::max(0,ix));
-                unsigned int uiy = amrex::min(ny-1,amrex::max(0,iy));
-                unsigned int uiz = amrex::min(nz-1,amrex::max(0,iz));
-                unsigned int cellid = (uix * ny + uiy) * nz + uiz;
-                pcount[cellid] += 1;
-            }
-        });
+    const int num_to_add = num_local_cells > 0 ?
+        amrex::Scan::ExclusiveSum(counts.size(), counts.data(), offsets.data()) : 0;
 
-        int num_to_add = amrex::Scan::ExclusiveSum(counts.size(), counts.data(), offsets.data());
+    // Particle IDs follow the global particle ordering, and are the same on all ranks
+    int num_total = 0;
+    const int global_offset = GlobalParticleOffset(num_to_add, num_total);
+    const int pid = ParticleType::NextID();
+    ParticleType::NextID(pid + num_total);
 
-        // Second: allocate the memory for these particles
-        auto& particle_tile = *this;
+    // Second: allocate the memory for these particles
+    auto& particle_tile = *this;
 
-        auto old_size = particle_tile.GetArrayOfStructs().size();
-        auto new_size = old_size + num_to_add;
-        particle_tile.resize(new_size);
+    auto old_size = particle_tile.GetArrayOfStructs().size();
+    auto new_size = old_size + num_to_add;
+    particle_tile.resize(new_size);
 
-        if (num_to_add == 0) return;
+    if (num_to_add > 0) {
 
         // Third: Actually initialize the particles at the right locations
         ParticleType* pstruct = particle_tile.GetArrayOfStructs()().data();
@@ -158,26 +332,31 @@ InitBeamFixedPPC (const amrex::IntVect& a_num_particles_per_cell,
         amrex::GpuArray<amrex::ParticleReal*, BeamIdx::nattribs> arrdata =
             particle_tile.GetStructOfArrays().realarray();
 
-        int procID = amrex::ParallelDescriptor::MyProc();
-        int pid = ParticleType::NextID();
-        ParticleType::NextID(pid + num_to_add);
+        // The whole beam ends up on the head rank
+        const int procID = nprocs - 1;
+        const int pid_local = pid + global_offset;
+        const std::uint64_t seed = GetBeamSeed(m_name);
 
         PhysConst phys_const = get_phys_const();
 
-        amrex::ParallelForRNG(domain_box,
-        [=] AMREX_GPU_DEVICE (int i, int j, int k, const amrex::RandomEngine& engine) noexcept
+        amrex::ParallelFor(local_box,
+        [=] AMREX_GPU_DEVICE (int i, int j, int k) noexcept
         {
-            int ix = i - lo.x;
-            int iy = j - lo.y;
-            int iz = k - lo.z;
-            int nx = hi.x-lo.x+1;
-            int ny = hi.y-lo.y+1;
-            int nz = hi.z-lo.z+1;
+            int ix = i - local_lo.x;
+            int iy = j - local_lo.y;
+            int iz = k - local_lo.z;
+            int nx = local_hi.x-local_lo.x+1;
+            int ny = local_hi.y-local_lo.y+1;
+            int nz = local_hi.z-local_lo.z+1;
             unsigned int uix = amrex::min(nx-1,amrex::max(0,ix));
             unsigned int uiy = amrex::min(ny-1,amrex::max(0,iy));
             unsigned int uiz = amrex::min(nz-1,amrex::max(0,iz));
             unsigned int cellid = (uix * ny + uiy) * nz + uiz;
 
+            const std::uint64_t global_cellid =
+                (static_cast<std::uint64_t>(i - lo.x) * (hi.y-lo.y+1) + (j - lo.y))
+                * (hi.z-lo.z+1) + (k - lo.z);
+
             int pidx = int(poffset[cellid] - poffset[0]);
 
             for (int i_part=0; i_part<num_ppc;i_part++)
@@ -196,16 +375,20 @@ InitBeamFixedPPC (const amrex::IntVect& a_num_particles_per_cell,
                 const amrex::Real density = get_density(x, y, z);
                 if (density < a_min_density) continue;
 
+                CounterRNG engine(seed, global_cellid*num_ppc + i_part);
                 amrex::Real u[3] = {0.,0.,0.};
                 get_momentum(u[0],u[1],u[2], engine);
 
                 const amrex::Real weight = density * scale_fac;
                 AddOneBeamParticle(pstruct, arrdata, x, y, z, u[0], u[1], u[2], weight,
-                                   pid, procID, pidx, phys_const.c);
+                                   pid_local, procID, pidx, phys_const.c);
 
                 ++pidx;
             }
         });
+    }
+
+    GatherBeamOnHeadRank(*this);
 }
 
 void
@@ -223,33 +406,48 @@ InitBeamFixedWeight (int num_to_add,
 
     if (num_to_add == 0) return;
     if (do_symmetrize) num_to_add /=4;
+    const int nsym = do_symmetrize ? 4 : 1;
 
     PhysConst phys_const = get_phys_const();
 
-    if (Hipace::HeadRank()) {
+    // Each rank generates a contiguous share of the particles. Particle i always draws its
+    // random numbers from stream i, so the beam does not depend on the number of ranks.
+    const int nprocs = amrex::ParallelDescriptor::NProcs();
+    const int myproc = amrex::ParallelDescriptor::MyProc();
+    const int i_start = static_cast<int>(amrex::Long(num_to_add)*myproc/nprocs);
+    const int i_end = static_cast<int>(amrex::Long(num_to_add)*(myproc+1)/nprocs);
+    const int num_local = i_end - i_start;
+
+    // Particle IDs follow the global particle ordering, and are the same on all ranks
+    const int pid = ParticleType::NextID();
+    ParticleType::NextID(pid + nsym*num_to_add);
 
-        auto& particle_tile = *this;
-        auto old_size = particle_tile.GetArrayOfStructs().size();
-        auto new_size = do_symmetrize? old_size + 4*num_to_add : old_size + num_to_add;
-        particle_tile.resize(new_size);
+    auto& particle_tile = *this;
+    auto old_size = particle_tile.GetArrayOfStructs().size();
+    auto new_size = old_size + nsym*num_local;
+    particle_tile.resize(new_size);
+
+    if (num_local > 0) {
 
         // Access particles' AoS and SoA
         ParticleType* pstruct = particle_tile.GetArrayOfStructs()().data();
         amrex::GpuArray<amrex::ParticleReal*, BeamIdx::nattribs> arrdata =
             particle_tile.GetStructOfArrays().realarray();
 
-        const int procID = amrex::ParallelDescriptor::MyProc();
-        const int pid = ParticleType::NextID();
-        ParticleType::NextID(pid + num_to_add);
+        // The whole beam ends up on the head rank
+        const int procID = nprocs - 1;
+        const int pid_local = pid + nsym*i_start;
+        const std::uint64_t seed = GetBeamSeed(m_name);
 
         const amrex::Real duz_per_uz0_dzeta = m_duz_per_uz0_dzeta;
-        amrex::ParallelForRNG(
-            num_to_add,
-            [=] AMREX_GPU_DEVICE (int i, const amrex::RandomEngine& engine) noexcept
+        amrex::ParallelFor(
+            num_local,
+            [=] AMREX_GPU_DEVICE (int i) noexcept
             {
-                const amrex::Real x = amrex::RandomNormal(0, pos_std[0], engine);
-                const amrex::Real y = amrex::RandomNormal(0, pos_std[1], engine);
-                const amrex::Real z = amrex::RandomNormal(0, pos_std[2], engine);
+                CounterRNG engine(seed, static_cast<std::uint64_t>(i_start + i));
+                const amrex::Real x = engine.RandomNormal(0, pos_std[0]);
+                const amrex::Real y = engine.RandomNormal(0, pos_std[1]);
+                const amrex::Real z = engine.RandomNormal(0, pos_std[2]);
                 amrex::Real u[3] = {0.,0.,0.};
                 get_momentum(u[0],u[1],u[2], engine, z, duz_per_uz0_dzeta);
 
@@ -261,25 +459,27 @@ InitBeamFixedWeight (int num_to_add,
                 {
                     AddOneBeamParticle(pstruct, arrdata, cental_x_pos+x, cental_y_pos+y,
                                        pos_mean[2]+z, u[0], u[1], u[2], weight,
-                                       pid, procID, i, phys_const.c);
+                                       pid_local, procID, i, phys_const.c);
                 } else {
                     weight /= 4;
                     AddOneBeamParticle(pstruct, arrdata, cental_x_pos+x, cental_y_pos+y,
                                        pos_mean[2]+z, u[0], u[1], u[2], weight,
-                                       pid, procID, 4*i, phys_const.c);
+                                       pid_local, procID, 4*i, phys_const.c);
                     AddOneBeamParticle(pstruct, arrdata, cental_x_pos-x, cental_y_pos+y,
                                        pos_mean[2]+z, -u[0], u[1], u[2], weight,
-                                       pid, procID, 4*i+1, phys_const.c);
+                                       pid_local, procID, 4*i+1, phys_const.c);
                     AddOneBeamParticle(pstruct, arrdata, cental_x_pos+x, cental_y_pos-y,
                                        pos_mean[2]+z, u[0], -u[1], u[2], weight,
-                                       pid, procID, 4*i+2, phys_const.c);
+                                       pid_local, procID, 4*i+2, phys_const.c);
                     AddOneBeamParticle(pstruct, arrdata, cental_x_pos-x, cental_y_pos-y,
                                        pos_mean[2]+z, -u[0], -u[1], u[2], weight,
-                                       pid, procID, 4*i+3, phys_const.c);
+                                       pid_local, procID, 4*i+3, phys_const.c);
                 }
             });
     }
 
+    GatherBeamOnHeadRank(*this);
+
     return;
 }
 
@@ -547,17 +747,6 @@ InitBeamFromFile (const std::string input_file,
 
     auto electrons = series.iterations[num_iteration].particles[name_particle];
 
-    // copy Data
-    const std::shared_ptr<input_type> r_x_data = electrons[name_r][name_rx].loadChunk<input_type>();
-    const std::shared_ptr<input_type> r_y_data = electrons[name_r][name_ry].loadChunk<input_type>();
-    const std::shared_ptr<input_type> r_z_data = electrons[name_r][name_rz].loadChunk<input_type>();
-    const std::shared_ptr<input_type> u_x_data = electrons[name_u][name_ux].loadChunk<input_type>();
-    const std::shared_ptr<input_type> u_y_data = electrons[name_u][name_uy].loadChunk<input_type>();
-    const std::shared_ptr<input_type> u_z_data = electrons[name_u][name_uz].loadChunk<input_type>();
-    const std::shared_ptr<input_type> w_w_data = electrons[name_w][name_ww].loadChunk<input_type>();
-
-    series.flush();
-
     // calculate the multiplier to convert to Hipace units
     if(Hipace::m_normalized_units) {
         if(n_0 == 0) {
@@ -615,20 +804,56 @@ InitBeamFromFile (const std::string input_file,
     const int num_to_add = electrons[name_r][name_rx].getExtent()[0];
     const PhysConst phys_const = get_phys_const();
 
-    if (Hipace::HeadRank()) {
-
-        auto& particle_tile = *this;
-        auto old_size = particle_tile.GetArrayOfStructs().size();
-        auto new_size = old_size + num_to_add;
-        particle_tile.resize(new_size);
-        ParticleType* pstruct = particle_tile.GetArrayOfStructs()().data();
-        amrex::GpuArray<amrex::ParticleReal*, BeamIdx::nattribs> arrdata =
-            particle_tile.GetStructOfArrays().realarray();
-        const int procID = amrex::ParallelDescriptor::MyProc();
-        const int pid = ParticleType::NextID();
-        ParticleType::NextID(pid + num_to_add);
-
-        for( int i=0; i < num_to_add; ++i)
+    // Each rank reads a contiguous share of the particles, in batches of at most
+    // m_file_read_batch_size particles that are converted and appended to the tile one after
+    // the other. The shares are gathered on the head rank at the end.
+    const int nprocs = amrex::ParallelDescriptor::NProcs();
+    const int myproc = amrex::ParallelDescriptor::MyProc();
+    const int i_start = static_cast<int>(amrex::Long(num_to_add)*myproc/nprocs);
+    const int i_end = static_cast<int>(amrex::Long(num_to_add)*(myproc+1)/nprocs);
+    const int num_local = i_end - i_start;
+
+    // Particle IDs follow the order in the file, and are the same on all ranks
+    const int pid = ParticleType::NextID();
+    ParticleType::NextID(pid + num_to_add);
+    // The whole beam ends up on the head rank
+    const int procID = nprocs - 1;
+
+    auto& particle_tile = *this;
+    auto old_size = particle_tile.GetArrayOfStructs().size();
+    auto new_size = old_size + num_local;
+    particle_tile.resize(new_size);
+    ParticleType* pstruct = particle_tile.GetArrayOfStructs()().data();
+    amrex::GpuArray<amrex::ParticleReal*, BeamIdx::nattribs> arrdata =
+        particle_tile.GetStructOfArrays().realarray();
+
+    for (int batch_start = i_start; batch_start < i_end;
+         batch_start += m_file_read_batch_size)
+    {
+        const int batch_size = std::min(m_file_read_batch_size, i_end - batch_start);
+        const openPMD::Offset offset {static_cast<std::uint64_t>(batch_start)};
+        const openPMD::Extent extent {static_cast<std::uint64_t>(batch_size)};
+
+        // copy Data
+        const std::shared_ptr<input_type> r_x_data =
+            electrons[name_r][name_rx].loadChunk<input_type>(offset, extent);
+        const std::shared_ptr<input_type> r_y_data =
+            electrons[name_r][name_ry].loadChunk<input_type>(offset, extent);
+        const std::shared_ptr<input_type> r_z_data =
+            electrons[name_r][name_rz].loadChunk<input_type>(offset, extent);
+        const std::shared_ptr<input_type> u_x_data =
+            electrons[name_u][name_ux].loadChunk<input_type>(offset, extent);
+        const std::shared_ptr<input_type> u_y_data =
+            electrons[name_u][name_uy].loadChunk<input_type>(offset, extent);
+        const std::shared_ptr<input_type> u_z_data =
+            electrons[name_u][name_uz].loadChunk<input_type>(offset, extent);
+        const std::shared_ptr<input_type> w_w_data =
+            electrons[name_w][name_ww].loadChunk<input_type>(offset, extent);
+
+        series.flush();
+
+        const int ip_start = batch_start - i_start;
+        for( int i=0; i < batch_size; ++i)
         {
             AddOneBeamParticle(pstruct, arrdata,
                                (amrex::Real)(r_x_data.get()[i] * unit_rx),
@@ -638,10 +863,12 @@ InitBeamFromFile (const std::string input_file,
                                (amrex::Real)(u_y_data.get()[i] * unit_uy),
                                (amrex::Real)(u_z_data.get()[i] * unit_uz),
                                (amrex::Real)(w_w_data.get()[i] * unit_ww),
-                               pid, procID, i, phys_const.c);
+                               pid + i_start, procID, ip_start + i, phys_const.c);
         }
     }
 
+    GatherBeamOnHeadRank(*this);
+
     return;
 }
 #endif // HIPACE_USE_OPENPMD
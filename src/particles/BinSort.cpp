@@ -6,7 +6,7 @@ BeamBins
 findParticlesInEachSlice (
     int /*lev*/, int ibox, amrex::Box bx,
     BeamParticleContainer& beam, const amrex::Geometry& geom,
-    const BoxSorter& a_box_sorter)
+    const BoxSorter& a_box_sorter, const bool reorder)
 {
     // Slice box: only 1 cell transversally, same as bx longitudinally.
     const amrex::Box cbx ({0,0,bx.smallEnd(2)}, {0,0,bx.bigEnd(2)});
@@ -35,5 +35,29 @@ findParticlesInEachSlice (
                 AMREX_D_DECL(0, 0, static_cast<int>((p.pos(2)-plo[2])*dxi[2]-lo.z)));
         });
 
+    beam.m_slice_ordered = reorder;
+    if (reorder && np > 0) {
+        // Move the particles of this box in slice order, so all slice kernels access contiguous
+        // particles without reading the permutation
+        BeamBins::index_type const * const indices = bins.permutationPtr();
+
+        BeamParticleContainer tmp(beam.get_name());
+        tmp.resize(np);
+        const auto tmp_ptd = tmp.getParticleTileData();
+        const auto src_ptd = beam.getConstParticleTileData();
+        amrex::ParallelFor(np,
+            [=] AMREX_GPU_DEVICE (long i) {
+                amrex::copyParticle(tmp_ptd, src_ptd, offset+indices[i], i);
+            });
+
+        const auto dst_ptd = beam.getParticleTileData();
+        const auto tmp_const_ptd = tmp.getConstParticleTileData();
+        amrex::ParallelFor(np,
+            [=] AMREX_GPU_DEVICE (long i) {
+                amrex::copyParticle(dst_ptd, tmp_const_ptd, i, offset+i);
+            });
+        amrex::Gpu::streamSynchronize();
+    }
+
     return bins;
 }
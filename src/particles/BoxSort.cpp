@@ -1,15 +1,21 @@
 #include "BoxSort.H"
+#include "pusher/GetAndSetPosition.H"
+#include "utils/HipaceProfilerWrapper.H"
 
 #include <AMReX_ParticleTransformation.H>
 
 void BoxSorter::sortParticlesByBox (BeamParticleContainer& a_beam,
-                                    const amrex::BoxArray a_ba, const amrex::Geometry& a_geom)
+                                    const amrex::BoxArray a_ba, const amrex::Geometry& a_geom,
+                                    const bool a_incremental)
 {
+    HIPACE_PROFILE("BoxSorter::sortParticlesByBox()");
+
     if (! m_particle_locator.isValid(a_ba)) m_particle_locator.build(a_ba, a_geom);
     auto assign_grid = m_particle_locator.getGridAssignor();
 
     int const np = a_beam.numParticles();
-    BeamParticleContainer::ParticleType* particle_ptr = a_beam.GetArrayOfStructs()().data();
+    const auto getPosition = GetParticlePosition<BeamParticleContainer>(a_beam);
+    const auto setPosition = SetParticlePosition<BeamParticleContainer>(a_beam);
 
     constexpr unsigned int max_unsigned_int = std::numeric_limits<unsigned int>::max();
 
@@ -20,17 +26,24 @@ void BoxSorter::sortParticlesByBox (BeamParticleContainer& a_beam,
     m_box_offsets.resize(num_boxes+1);
 
     amrex::Gpu::DeviceVector<unsigned int> dst_indices(np);
+    amrex::Gpu::DeviceVector<int> dst_boxes(np);
 
     auto p_box_counts = m_box_counts.dataPtr();
     auto p_dst_indices = dst_indices.dataPtr();
+    auto p_dst_boxes = dst_boxes.dataPtr();
     AMREX_FOR_1D ( np, i,
     {
-        int dst_box = assign_grid(particle_ptr[i]);
+        // the grid assignor takes a particle: locate a local copy of the position
+        BeamParticleContainer::ParticleType p;
+        int id;
+        getPosition(i, p.pos(0), p.pos(1), p.pos(2), id);
+        int dst_box = assign_grid(p);
         if (dst_box < 0) {
             // particle has left domain transversely, stick it at the end and invalidate
             dst_box = num_boxes;
-            particle_ptr[i].id() = -std::abs(particle_ptr[i].id());
+            setPosition(i, p.pos(0), p.pos(1), p.pos(2), -std::abs(id));
         }
+        p_dst_boxes[i] = dst_box;
         unsigned int index = amrex::Gpu::Atomic::Inc(
             &p_box_counts[dst_box], max_unsigned_int);
         p_dst_indices[i] = index;
@@ -38,20 +51,95 @@ void BoxSorter::sortParticlesByBox (BeamParticleContainer& a_beam,
 
     amrex::Gpu::exclusive_scan(m_box_counts.begin(), m_box_counts.end(), m_box_offsets.begin());
 
-    BeamParticleContainer tmp(a_beam.get_name());
-    tmp.resize(np);
+    // Index of the first particle from which the particles have to be re-sorted.
+    // The particles before it are already at their final position.
+    int sort_start = 0;
+    if (a_incremental && np > 0) {
+        // The particles are sorted by box up to the first one with a smaller box index
+        // than its predecessor. Typically, this is where particles received from upstream
+        // were appended after the particles of the boxes left on this rank.
+        amrex::ReduceOps<amrex::ReduceOpMin> reduce_op;
+        amrex::ReduceData<int> reduce_data(reduce_op);
+        reduce_op.eval(np-1, reduce_data,
+            [=] AMREX_GPU_DEVICE (int i) -> amrex::GpuTuple<int>
+            {
+                return p_dst_boxes[i+1] < p_dst_boxes[i] ? i+1 : np;
+            });
+        // for a single particle, the reduction is empty and returns the identity INT_MAX
+        const int sorted_size = amrex::min(amrex::get<0>(reduce_data.value()), np);
 
-    auto p_box_offsets = m_box_offsets.dataPtr();
-    AMREX_FOR_1D ( np, i,
+        // already sorted, nothing to move
+        if (sorted_size == np) return;
+
+        // smallest box among the particles that are not sorted yet
+        amrex::ReduceData<int> reduce_data_box(reduce_op);
+        reduce_op.eval(np-sorted_size, reduce_data_box,
+            [=] AMREX_GPU_DEVICE (int i) -> amrex::GpuTuple<int>
+            {
+                return p_dst_boxes[sorted_size+i];
+            });
+        const int min_box = amrex::get<0>(reduce_data_box.value());
+
+        // the sorted particles in boxes up to min_box can stay where they are
+        amrex::ReduceData<int> reduce_data_start(reduce_op);
+        reduce_op.eval(sorted_size, reduce_data_start,
+            [=] AMREX_GPU_DEVICE (int i) -> amrex::GpuTuple<int>
+            {
+                return p_dst_boxes[i] > min_box ? i : sorted_size;
+            });
+        sort_start = amrex::get<0>(reduce_data_start.value());
+    }
+
+    if (sort_start == 0) {
+        BeamParticleContainer tmp(a_beam.get_name());
+        tmp.resize(np);
+
+        auto p_box_offsets = m_box_offsets.dataPtr();
+        AMREX_FOR_1D ( np, i,
+        {
+            p_dst_indices[i] += p_box_offsets[p_dst_boxes[i]];
+        });
+
+        amrex::scatterParticles(tmp, a_beam, np, dst_indices.dataPtr());
+
+        a_beam.swap(tmp);
+        return;
+    }
+
+    // Only re-sort the particles in [sort_start, np). All of them belong to boxes larger than
+    // or equal to those of the particles before sort_start, so they can be sorted among
+    // themselves and placed right after.
+    const int n_sort = np - sort_start;
+    amrex::Gpu::DeviceVector<index_type> local_counts(num_boxes+1, 0);
+    amrex::Gpu::DeviceVector<index_type> local_offsets(num_boxes+1);
+    auto p_local_counts = local_counts.dataPtr();
+    AMREX_FOR_1D ( n_sort, i,
     {
-        int dst_box = assign_grid(particle_ptr[i]);
-        if (dst_box < 0) dst_box = num_boxes;
-        p_dst_indices[i] += p_box_offsets[dst_box];
+        p_dst_indices[i] = amrex::Gpu::Atomic::Inc(
+            &p_local_counts[p_dst_boxes[sort_start+i]], max_unsigned_int);
     });
 
-    amrex::scatterParticles(tmp, a_beam, np, dst_indices.dataPtr());
+    amrex::Gpu::exclusive_scan(local_counts.begin(), local_counts.end(), local_offsets.begin());
 
-    a_beam.swap(tmp);
+    BeamParticleContainer tmp(a_beam.get_name());
+    tmp.resize(n_sort);
+
+    auto p_local_offsets = local_offsets.dataPtr();
+    const auto src_ptd = a_beam.getConstParticleTileData();
+    const auto tmp_ptd = tmp.getParticleTileData();
+    AMREX_FOR_1D ( n_sort, i,
+    {
+        amrex::copyParticle(tmp_ptd, src_ptd, sort_start+i,
+                            p_dst_indices[i] + p_local_offsets[p_dst_boxes[sort_start+i]]);
+    });
+
+    const auto dst_ptd = a_beam.getParticleTileData();
+    const auto tmp_const_ptd = tmp.getConstParticleTileData();
+    AMREX_FOR_1D ( n_sort, i,
+    {
+        amrex::copyParticle(dst_ptd, tmp_const_ptd, i, sort_start+i);
+    });
+    amrex::Gpu::streamSynchronize();
 }
 
 int
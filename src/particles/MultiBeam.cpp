@@ -2,8 +2,11 @@
 #include "deposition/BeamDepositCurrent.H"
 #include "particles/BinSort.H"
 #include "pusher/BeamParticleAdvance.H"
+#include "pusher/GetAndSetPosition.H"
 #include "utils/HipaceProfilerWrapper.H"
 
+#include <limits>
+
 MultiBeam::MultiBeam (amrex::AmrCore* /*amr_core*/)
 {
 
@@ -16,6 +19,8 @@ MultiBeam::MultiBeam (amrex::AmrCore* /*amr_core*/)
         m_all_beams.emplace_back(BeamParticleContainer(m_names[i]));
     }
     m_n_real_particles.resize(m_nbeams, 0);
+    pp.query("incremental_box_sort", m_incremental_box_sort);
+    pp.query("reorder_by_slice", m_reorder_by_slice);
 }
 
 void
@@ -48,7 +53,8 @@ MultiBeam::findParticlesInEachSlice (int lev, int ibox, amrex::Box bx, amrex::Ge
 {
     amrex::Vector<BeamBins> bins;
     for (int i=0; i<m_nbeams; i++) {
-        bins.emplace_back(::findParticlesInEachSlice(lev, ibox, bx, m_all_beams[i], geom, a_box_sorter_vec[i]));
+        bins.emplace_back(::findParticlesInEachSlice(lev, ibox, bx, m_all_beams[i], geom,
+                                                     a_box_sorter_vec[i], m_reorder_by_slice));
     }
     return bins;
 }
@@ -60,7 +66,8 @@ MultiBeam::sortParticlesByBox (
 {
     a_box_sorter_vec.resize(m_nbeams);
     for (int i=0; i<m_nbeams; i++) {
-        a_box_sorter_vec[i].sortParticlesByBox(m_all_beams[i], a_ba, a_geom);
+        a_box_sorter_vec[i].sortParticlesByBox(m_all_beams[i], a_ba, a_geom,
+                                               m_incremental_box_sort);
     }
 }
 
@@ -73,6 +80,9 @@ MultiBeam::AdvanceBeamParticlesSlice (
     for (int i=0; i<m_nbeams; i++) {
         ::AdvanceBeamParticlesSlice(m_all_beams[i], fields, gm, lev, islice, bx,
                                     a_box_sorter_vec[i].boxOffsetsPtr()[ibox], bins[i]);
+        const int islice_local = islice - bx.smallEnd(2);
+        m_num_particle_pushes += bins[i].offsetsPtr()[islice_local+1]
+                                 - bins[i].offsetsPtr()[islice_local];
     }
 }
 
@@ -119,6 +129,66 @@ MultiBeam::NGhostParticles (int ibeam, amrex::Vector<BeamBins>& bins, amrex::Box
         - offsets[bx.bigEnd(Direction::z)-bx.smallEnd(Direction::z)];
 }
 
+int
+MultiBeam::NumParticlesInSlice (const amrex::Vector<BeamBins>& bins,
+                                const int islice_local) const
+{
+    int np = 0;
+    for (int i=0; i<m_nbeams; i++){
+        BeamBins::index_type const * offsets = bins[i].offsetsPtr();
+        np += offsets[islice_local+1] - offsets[islice_local];
+    }
+    return np;
+}
+
+void
+MultiBeam::ExtendSliceExtent (amrex::Vector<BeamBins>& bins, const int islice_local,
+                              const amrex::Vector<BoxSorter>& box_sorters, const int ibox,
+                              amrex::RealBox& extent)
+{
+    HIPACE_PROFILE("MultiBeam::ExtendSliceExtent()");
+    constexpr amrex::Real huge = std::numeric_limits<amrex::Real>::max();
+
+    for (int i=0; i<m_nbeams; i++){
+        auto& ptile = m_all_beams[i];
+        BeamBins::index_type const * const indices = getBinPermutation(bins[i], ptile);
+        BeamBins::index_type const * const offsets = bins[i].offsetsPtr();
+        // particles of this slice and of the next one (transverse currents for the predictor-
+        // corrector loop), which are contiguous in the bins
+        const int cell_start = offsets[std::max(islice_local-1, 0)];
+        const int cell_stop = offsets[islice_local+1];
+        const int box_offset = box_sorters[i].boxOffsetsPtr()[ibox];
+        // ghost particles are at the end of the particle array
+        const int n_real = static_cast<int>(m_n_real_particles[i]);
+        const int nghost = islice_local == 0 ? ptile.numParticles() - n_real : 0;
+        const int ghost_offset = n_real - box_offset;
+        const int nbinned = cell_stop - cell_start;
+        const auto getPosition = GetParticlePosition<BeamParticleContainer>(ptile, box_offset);
+
+        amrex::ReduceOps<amrex::ReduceOpMin, amrex::ReduceOpMax,
+                         amrex::ReduceOpMin, amrex::ReduceOpMax> reduce_op;
+        amrex::ReduceData<amrex::Real, amrex::Real, amrex::Real, amrex::Real>
+            reduce_data(reduce_op);
+        using ReduceTuple = typename decltype(reduce_data)::Type;
+        reduce_op.eval(nbinned + nghost, reduce_data,
+            [=] AMREX_GPU_DEVICE (int idx) -> ReduceTuple
+            {
+                const int ip = idx >= nbinned ? ghost_offset + idx - nbinned
+                             : indices ? indices[cell_start+idx] : cell_start+idx;
+                amrex::ParticleReal xp, yp, zp;
+                int pid;
+                getPosition(ip, xp, yp, zp, pid);
+                if (pid < 0) return {huge, -huge, huge, -huge};
+                return {amrex::Real(xp), amrex::Real(xp), amrex::Real(yp), amrex::Real(yp)};
+            });
+        const ReduceTuple result = reduce_data.value();
+        extent.setLo(0, std::min(extent.lo(0), amrex::get<0>(result)));
+        extent.setHi(0, std::max(extent.hi(0), amrex::get<1>(result)));
+        extent.setLo(1, std::min(extent.lo(1), amrex::get<2>(result)));
+        extent.setHi(1, std::max(extent.hi(1), amrex::get<3>(result)));
+    }
+}
+
 void
 MultiBeam::RemoveGhosts ()
 {
@@ -144,10 +214,8 @@ MultiBeam::PackLocalGhostParticles (int it, const amrex::Vector<BoxSorter>& box_
         ptile.resize(new_size);
 
         // Copy particles in box it to ghost particles
-        // Access AoS particle data
-        auto& aos = ptile.GetArrayOfStructs();
-        const auto& pos_structs_src = aos.begin() + offset_box_left;
-        const auto& pos_structs_dst = aos.begin() + old_size;
+        const auto getPosition = GetParticlePosition<BeamParticleContainer>(ptile, offset_box_left);
+        const auto setPosition = SetParticlePosition<BeamParticleContainer>(ptile, old_size);
         // Access SoA particle data
         auto& soa = ptile.GetStructOfArrays(); // For momenta and weights
         const auto  wp_src = soa.GetRealData(BeamIdx::w).data()  + offset_box_left;
@@ -162,10 +230,10 @@ MultiBeam::PackLocalGhostParticles (int it, const amrex::Vector<BoxSorter>& box_
         amrex::ParallelFor(
             nghost,
             [=] AMREX_GPU_DEVICE (long idx) {
-                pos_structs_dst[idx].id() = pos_structs_src[idx].id();
-                pos_structs_dst[idx].pos(0) = pos_structs_src[idx].pos(0);
-                pos_structs_dst[idx].pos(1) = pos_structs_src[idx].pos(1);
-                pos_structs_dst[idx].pos(2) = pos_structs_src[idx].pos(2);
+                amrex::ParticleReal xp, yp, zp;
+                int pid;
+                getPosition(idx, xp, yp, zp, pid);
+                setPosition(idx, xp, yp, zp, pid);
                 wp_dst[idx] = wp_src[idx];
                 uxp_dst[idx] = uxp_src[idx];
                 uyp_dst[idx] = uyp_src[idx];
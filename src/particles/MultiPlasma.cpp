@@ -2,12 +2,16 @@
 #include "particles/deposition/PlasmaDepositCurrent.H"
 #include "particles/pusher/PlasmaParticleAdvance.H"
 
+#include <algorithm>
+#include <limits>
+
 MultiPlasma::MultiPlasma (amrex::AmrCore* amr_core)
 {
 
     amrex::ParmParse pp("plasmas");
     pp.getarr("names", m_names);
     pp.query("adaptive_density", m_adaptive_density);
+    ResetDisturbedExtent();
     if (m_names[0] == "no_plasma") return;
     m_nplasmas = m_names.size();
     for (int i = 0; i < m_nplasmas; ++i) {
@@ -67,14 +71,54 @@ MultiPlasma::AdvanceParticles (
     Fields & fields, amrex::Geometry const& gm, bool temp_slice, bool do_push,
     bool do_update, bool do_shift, int lev)
 {
+    // the push to the next slice finds the disturbed particles, if requested
+    amrex::RealBox* disturbed_extent =
+        (m_disturbed_threshold >= 0. && do_push && !temp_slice) ? &m_disturbed_extent : nullptr;
     for (auto& plasma : m_all_plasmas) {
-        AdvancePlasmaParticles(plasma, fields, gm, temp_slice, do_push, do_update, do_shift, lev);
+        AdvancePlasmaParticles(plasma, fields, gm, temp_slice, do_push, do_update, do_shift, lev,
+                               disturbed_extent, m_disturbed_threshold);
+        // the push to the next slice happens once per slice outside of temporary pushes
+        if (do_push && !temp_slice && plasma.m_level == lev) {
+            m_num_particle_pushes += plasma.TotalNumberOfParticles(false, true);
+        }
     }
 }
 
+bool
+MultiPlasma::IsNeutralAtRest () const
+{
+    if (!AllSpeciesNeutralizeBackground()) return false;
+    for (auto& plasma : m_all_plasmas) {
+        if (plasma.m_can_ionize) return false;
+        // a drifting or thermal plasma carries currents ahead of the beam
+        if (plasma.m_u_mean != amrex::RealVect(0., 0., 0.) ||
+            plasma.m_u_std != amrex::RealVect(0., 0., 0.)) return false;
+    }
+    return true;
+}
+
+void
+MultiPlasma::ExtendDisturbedExtent (amrex::RealBox& extent)
+{
+    for (int idim = 0; idim < Direction::z; ++idim) {
+        extent.setLo(idim, std::min(extent.lo(idim), m_disturbed_extent.lo(idim)));
+        extent.setHi(idim, std::max(extent.hi(idim), m_disturbed_extent.hi(idim)));
+    }
+    ResetDisturbedExtent();
+}
+
+void
+MultiPlasma::ResetDisturbedExtent ()
+{
+    constexpr amrex::Real huge = std::numeric_limits<amrex::Real>::max();
+    m_disturbed_extent = amrex::RealBox({AMREX_D_DECL(huge, huge, huge)},
+                                        {AMREX_D_DECL(-huge, -huge, -huge)});
+}
+
 void
 MultiPlasma::ResetParticles (int lev, bool initial)
 {
+    if (initial) ResetDisturbedExtent();
     for (auto& plasma : m_all_plasmas) {
         ResetPlasmaParticles(plasma, lev, initial);
     }
@@ -78,6 +78,12 @@ PlasmaParticleContainer::ReadParameters ()
                                      "plasma radius itself");
     pp.query("parabolic_curvature", m_parabolic_curvature);
     pp.query("max_qsa_weighting_factor", m_max_qsa_weighting_factor);
+    pp.query("ionization_probability_cutoff", m_ionization_probability_cutoff);
+    pp.query("ionization_rate_table", m_use_adk_table);
+    pp.query("ionization_rate_table_size", m_adk_table_size);
+    AMREX_ALWAYS_ASSERT_WITH_MESSAGE(m_ionization_probability_cutoff >= 0. &&
+                                     m_ionization_probability_cutoff < 1.,
+                                     "ionization_probability_cutoff must be in [0, 1)");
     amrex::Vector<amrex::Real> tmp_vector;
     if (pp.queryarr("ppc", tmp_vector)){
         AMREX_ALWAYS_ASSERT_WITH_MESSAGE(tmp_vector.size() == AMREX_SPACEDIM-1,
@@ -183,21 +189,69 @@ IonizationModule (const int lev,
         const amrex::Real * const uyp = soa_ion.GetRealData(PlasmaIdx::uy).data();
         const amrex::Real * const psip = soa_ion.GetRealData(PlasmaIdx::psi).data();
 
-        // Make Ion Mask and load ADK prefactors
-        // Ion Mask is necessary to only resize electron particle tile once
-        amrex::Gpu::DeviceVector<uint8_t> ion_mask(ptile_ion.numParticles(), 0);
-        uint8_t* AMREX_RESTRICT p_ion_mask = ion_mask.data();
-        amrex::Gpu::DeviceScalar<uint32_t> num_new_electrons(0);
-        uint32_t* AMREX_RESTRICT p_num_new_electrons = num_new_electrons.dataPtr();
+        // Build the list of ions that can still be ionized, once per time step.
+        // Fully ionized ions are removed from it below, so they are skipped entirely.
+        const int max_ion_lev = m_adk_power.size();
+        if (m_ionizable_ids.count(mfi_ion.tileIndex()) == 0) {
+            const long num_ions = ptile_ion.numParticles();
+            amrex::Gpu::DeviceVector<int> all_ids(num_ions);
+            int* AMREX_RESTRICT p_all_ids = all_ids.data();
+            const int num_found = amrex::Scan::PrefixSum<int>(num_ions,
+                [=] AMREX_GPU_DEVICE (int ip) -> int {
+                    return ion_lev[ip] < max_ion_lev;
+                },
+                [=] AMREX_GPU_DEVICE (int ip, int const& offset) {
+                    if (ion_lev[ip] < max_ion_lev) p_all_ids[offset] = ip;
+                },
+                amrex::Scan::Type::exclusive, amrex::Scan::retSum);
+            all_ids.resize(num_found);
+            m_ionizable_ids[mfi_ion.tileIndex()].swap(all_ids);
+        }
+        auto& ionizable_ids = m_ionizable_ids[mfi_ion.tileIndex()];
+        const int num_ionizable = ionizable_ids.size();
+        if (num_ionizable == 0) continue;
+        const int* AMREX_RESTRICT p_ids = ionizable_ids.data();
+
+        // The gathered field is a weighted average of the field on the cells around the
+        // particle, so it is bounded by the largest field on the slice. If that is too weak to
+        // ionize any level, the gather and the ADK rate are skipped for the whole slice.
+        if (m_adk_lowest_min_field > 0.) {
+            amrex::ReduceOps<amrex::ReduceOpMax> reduce_op;
+            amrex::ReduceData<amrex::Real> reduce_data(reduce_op);
+            using ReduceTuple = typename decltype(reduce_data)::Type;
+            reduce_op.eval(tilebox, reduce_data,
+                [=] AMREX_GPU_DEVICE (int i, int j, int k) -> ReduceTuple
+                {
+                    const amrex::Real Ex = exmby_arr(i,j,k) + by_arr(i,j,k) * phys_const.c;
+                    const amrex::Real Ey = eypbx_arr(i,j,k) - bx_arr(i,j,k) * phys_const.c;
+                    const amrex::Real Ez = ez_arr(i,j,k);
+                    return {Ex*Ex + Ey*Ey + Ez*Ez};
+                });
+            const amrex::Real max_field_sq = amrex::get<0>(reduce_data.value());
+            if (max_field_sq <= m_adk_lowest_min_field*m_adk_lowest_min_field) continue;
+        }
+
+        // Ion mask of size num_ionizable+1, its exclusive sum gives the index of each new electron
+        // in a deterministic order and the total number of new electrons as the last element
+        amrex::Gpu::DeviceVector<int> ion_mask(num_ionizable+1, 0);
+        int* AMREX_RESTRICT p_ion_mask = ion_mask.data();
+        // number of ions reaching the last ion level in this slice
+        amrex::Gpu::DeviceScalar<int> num_fully_ionized(0);
+        int* AMREX_RESTRICT p_num_fully_ionized = num_fully_ionized.dataPtr();
         amrex::Real* AMREX_RESTRICT adk_prefactor = m_adk_prefactor.data();
         amrex::Real* AMREX_RESTRICT adk_exp_prefactor = m_adk_exp_prefactor.data();
         amrex::Real* AMREX_RESTRICT adk_power = m_adk_power.data();
+        amrex::Real* AMREX_RESTRICT adk_min_field = m_adk_min_field.data();
+        const bool use_adk_table = m_use_adk_table;
+        const int adk_table_size = m_adk_table_size;
+        amrex::Real* AMREX_RESTRICT adk_table = m_adk_table.data();
+        amrex::Real* AMREX_RESTRICT adk_table_log_emin = m_adk_table_log_emin.data();
+        amrex::Real* AMREX_RESTRICT adk_table_inv_dlog_e = m_adk_table_inv_dlog_e.data();
 
-        long num_ions = ptile_ion.numParticles();
-
-        amrex::ParallelForRNG(num_ions,
-            [=] AMREX_GPU_DEVICE (long ip, const amrex::RandomEngine& engine) {
+        amrex::ParallelForRNG(num_ionizable,
+            [=] AMREX_GPU_DEVICE (long i, const amrex::RandomEngine& engine) {
 
+            const int ip = p_ids[i];
             amrex::ParticleReal xp, yp, zp;
             int pid;
             getPosition(ip, xp, yp, zp, pid);
@@ -217,47 +271,65 @@ IonizationModule (const int lev,
             const amrex::ParticleReal Eyp = EypBxp - Bxp * phys_const.c;
             const amrex::ParticleReal Ep = std::sqrt( Exp*Exp + Eyp*Eyp + Ezp*Ezp );
 
+            const int ion_lev_loc = ion_lev[ip];
+            // field too weak to ionize this level
+            if (Ep <= adk_min_field[ion_lev_loc]) return;
+
             // Compute probability of ionization p
             const amrex::Real psi_1 = ( psip[ip] *
                 phys_const.q_e / (phys_const.m_e * phys_const.c * phys_const.c) ) + 1._rt;
             const amrex::Real gammap = (1.0_rt + uxp[ip] * uxp[ip] * clightsq
                                                + uyp[ip] * uyp[ip] * clightsq
                                                + psi_1 * psi_1 ) / ( 2.0_rt * psi_1 );
-            const int ion_lev_loc = ion_lev[ip];
             // gamma / (psi + 1) to complete dt for QSA
-            amrex::Real w_dtau = gammap / psi_1 * adk_prefactor[ion_lev_loc] *
-                std::pow(Ep, adk_power[ion_lev_loc]) *
-                std::exp( adk_exp_prefactor[ion_lev_loc]/Ep );
+            amrex::Real w_dtau = 0._rt;
+            if (use_adk_table) {
+                // linear interpolation of log(rate) in log(E), clamped to the table
+                const amrex::Real x = amrex::min(
+                    (std::log(Ep) - adk_table_log_emin[ion_lev_loc])
+                    * adk_table_inv_dlog_e[ion_lev_loc], amrex::Real(adk_table_size - 1));
+                const int j = amrex::min(static_cast<int>(x), adk_table_size - 2);
+                const amrex::Real f = x - j;
+                const amrex::Real* table = adk_table + ion_lev_loc * adk_table_size;
+                w_dtau = gammap / psi_1 * std::exp( (1._rt - f) * table[j] + f * table[j+1] );
+            } else {
+                w_dtau = gammap / psi_1 * adk_prefactor[ion_lev_loc] *
+                    std::pow(Ep, adk_power[ion_lev_loc]) *
+                    std::exp( adk_exp_prefactor[ion_lev_loc]/Ep );
+            }
             amrex::Real p = 1._rt - std::exp( - w_dtau );
 
             amrex::Real random_draw = amrex::Random(engine);
             if (random_draw < p)
             {
                 ion_lev[ip] += 1;
-                p_ion_mask[ip] = 1;
-                amrex::Gpu::Atomic::Add( p_num_new_electrons, 1u );
+                p_ion_mask[i] = 1;
+                if (ion_lev[ip] == max_ion_lev) {
+                    amrex::Gpu::Atomic::Add(p_num_fully_ionized, 1);
+                }
             }
         });
-        amrex::Gpu::synchronize();
 
-        if (num_new_electrons.dataValue() == 0) continue;
+        const int num_new_electrons =
+            amrex::Scan::ExclusiveSum(num_ionizable+1, p_ion_mask, p_ion_mask);
+
+        if (num_new_electrons == 0) continue;
 
         if(Hipace::m_verbose >= 3) {
             amrex::Print() << "Number of ionized Plasma Particles: "
-            << num_new_electrons.dataValue() << "\n";
+            << num_new_electrons << "\n";
         }
 
-
         // resize electron particle tile
         const auto old_size = ptile_elec.numParticles();
-        const auto new_size = old_size + num_new_electrons.dataValue();
+        const auto new_size = old_size + num_new_electrons;
         ptile_elec.resize(new_size);
 
         // Load electron soa and aos after resize
         ParticleType* pstruct_elec = ptile_elec.GetArrayOfStructs()().data();
         const int procID = amrex::ParallelDescriptor::MyProc();
         const long pid_start = ParticleType::NextID();
-        ParticleType::NextID(pid_start + num_new_electrons.dataValue());
+        ParticleType::NextID(pid_start + num_new_electrons);
 
         auto arrdata_ion = ptile_ion.GetStructOfArrays().realarray();
         auto arrdata_elec = ptile_elec.GetStructOfArrays().realarray();
@@ -265,14 +337,12 @@ IonizationModule (const int lev,
 
         const int init_ion_lev = m_product_pc->m_init_ion_lev;
 
-        amrex::Gpu::DeviceScalar<uint32_t> ip_elec(0);
-        uint32_t * AMREX_RESTRICT p_ip_elec = ip_elec.dataPtr();
-
-        amrex::ParallelFor(num_ions,
-            [=] AMREX_GPU_DEVICE (long ip) {
+        amrex::ParallelFor(num_ionizable,
+            [=] AMREX_GPU_DEVICE (long i) {
 
-            if(p_ion_mask[ip] != 0) {
-                const long pid = amrex::Gpu::Atomic::Add( p_ip_elec, 1u );
+            if(p_ion_mask[i+1] != p_ion_mask[i]) {
+                const int ip = p_ids[i];
+                const long pid = p_ion_mask[i];
                 const long pidx = pid + old_size;
 
                 // Copy ion data to new electron
@@ -325,6 +395,20 @@ IonizationModule (const int lev,
                 int_arrdata_elec[PlasmaIdx::ion_lev][pidx] = init_ion_lev;
             }
         });
-        amrex::Gpu::synchronize();
+
+        // Remove the ions that just became fully ionized from the list, if there are any
+        if (num_fully_ionized.dataValue() == 0) continue;
+        amrex::Gpu::DeviceVector<int> new_ionizable_ids(num_ionizable);
+        int* AMREX_RESTRICT p_new_ids = new_ionizable_ids.data();
+        const int num_still_ionizable = amrex::Scan::PrefixSum<int>(num_ionizable,
+            [=] AMREX_GPU_DEVICE (int i) -> int {
+                return ion_lev[p_ids[i]] < max_ion_lev;
+            },
+            [=] AMREX_GPU_DEVICE (int i, int const& offset) {
+                if (ion_lev[p_ids[i]] < max_ion_lev) p_new_ids[offset] = p_ids[i];
+            },
+            amrex::Scan::Type::exclusive, amrex::Scan::retSum);
+        new_ionizable_ids.resize(num_still_ionizable);
+        ionizable_ids.swap(new_ionizable_ids);
     }
 }
@@ -6,6 +6,38 @@
 #include "utils/IonizationEnergiesTable.H"
 #include <cmath>
 
+namespace
+{
+    /** \brief Find the field at which log(w_dtau) of the ADK formula reaches a target value.
+     * The rate increases monotonically up to E_peak = exp_prefactor/power, the bisection is
+     * done below that. Returns E_peak if the target is never reached.
+     *
+     * \param[in] log_w_target target value of log(w_dtau)
+     * \param[in] log_prefactor log of the ADK prefactor times the weighting factor
+     * \param[in] power ADK power
+     * \param[in] exp_prefactor ADK exponential prefactor
+     */
+    double FindADKField (const double log_w_target, const double log_prefactor,
+                         const double power, const double exp_prefactor)
+    {
+        auto log_w_dtau = [&] (double E) {
+            return log_prefactor + power * std::log(E) + exp_prefactor / E;
+        };
+        double E_lo = 0.;
+        double E_hi = exp_prefactor / power;
+        if (log_w_dtau(E_hi) < log_w_target) return E_hi;
+        for (int iter=0; iter<100; ++iter) {
+            const double E_mid = 0.5 * (E_lo + E_hi);
+            if (log_w_dtau(E_mid) < log_w_target) {
+                E_lo = E_mid;
+            } else {
+                E_hi = E_mid;
+            }
+        }
+        return E_lo;
+    }
+}
+
 void
 PlasmaParticleContainer::
 InitParticles (const amrex::IntVect& a_num_particles_per_cell,
@@ -241,11 +273,22 @@ InitIonizationModule (const amrex::Geometry& geom,
     m_adk_power.resize(ion_atomic_number);
     m_adk_prefactor.resize(ion_atomic_number);
     m_adk_exp_prefactor.resize(ion_atomic_number);
+    m_adk_min_field.resize(ion_atomic_number);
+    if (m_use_adk_table) {
+        AMREX_ALWAYS_ASSERT_WITH_MESSAGE(m_adk_table_size >= 2,
+            "ionization_rate_table_size must be at least 2");
+        m_adk_table_log_emin.resize(ion_atomic_number);
+        m_adk_table_inv_dlog_e.resize(ion_atomic_number);
+    }
+    amrex::Vector<amrex::Real> h_adk_table(m_use_adk_table ? ion_atomic_number*m_adk_table_size : 0);
 
     amrex::Real* AMREX_RESTRICT ionization_energies = h_ionization_energies.data();
     amrex::Real* AMREX_RESTRICT p_adk_power = m_adk_power.data();
     amrex::Real* AMREX_RESTRICT p_adk_prefactor = m_adk_prefactor.data();
     amrex::Real* AMREX_RESTRICT p_adk_exp_prefactor = m_adk_exp_prefactor.data();
+    amrex::Real* AMREX_RESTRICT p_adk_min_field = m_adk_min_field.data();
+    amrex::Real* AMREX_RESTRICT p_adk_table_log_emin = m_adk_table_log_emin.data();
+    amrex::Real* AMREX_RESTRICT p_adk_table_inv_dlog_e = m_adk_table_inv_dlog_e.data();
 
     for (int i=0; i<ion_atomic_number; ++i)
     {
@@ -257,5 +300,46 @@ InitIonizationModule (const amrex::Geometry& geom,
         p_adk_prefactor[i] = dt * wa * C2 * ( Uion/(2*UH) )
             * std::pow(2*std::pow((Uion/UH),3./2)*Ea,2*n_eff - 1);
         p_adk_exp_prefactor[i] = -2./3 * std::pow( Uion/UH,3./2) * Ea;
+
+        // Field below which the ionization probability is smaller than the cutoff, for the
+        // largest allowed weighting factor gamma/(psi+1)
+        const double log_max_prefactor =
+            std::log(m_max_qsa_weighting_factor * static_cast<double>(p_adk_prefactor[i]));
+        p_adk_min_field[i] = 0._rt;
+        if (m_ionization_probability_cutoff > 0.) {
+            p_adk_min_field[i] = FindADKField(
+                std::log(-std::log1p(-m_ionization_probability_cutoff)),
+                log_max_prefactor, p_adk_power[i], p_adk_exp_prefactor[i]);
+        }
+
+        if (m_use_adk_table) {
+            // log(rate) on a log-spaced field grid, from where the probability drops below
+            // 1e-30 up to the peak of the ADK formula
+            const double E_peak = p_adk_exp_prefactor[i] / p_adk_power[i];
+            const double E_min = amrex::min(0.5 * E_peak,
+                amrex::max(static_cast<double>(p_adk_min_field[i]),
+                           FindADKField(std::log(1.e-30), log_max_prefactor, p_adk_power[i],
+                                        p_adk_exp_prefactor[i])));
+            const double log_E_min = std::log(E_min);
+            const double dlog_E = (std::log(E_peak) - log_E_min) / (m_adk_table_size - 1);
+            p_adk_table_log_emin[i] = log_E_min;
+            p_adk_table_inv_dlog_e[i] = 1. / dlog_E;
+            for (int j=0; j<m_adk_table_size; ++j) {
+                const double E = std::exp(log_E_min + j * dlog_E);
+                h_adk_table[i*m_adk_table_size + j] = std::log(p_adk_prefactor[i])
+                    + p_adk_power[i] * std::log(E) + p_adk_exp_prefactor[i] / E;
+            }
+            // never ionize below the first point of the table
+            p_adk_min_field[i] = amrex::max(static_cast<double>(p_adk_min_field[i]), E_min);
+        }
+        m_adk_lowest_min_field = (i == 0) ? p_adk_min_field[i]
+                                          : amrex::min(m_adk_lowest_min_field, p_adk_min_field[i]);
+    }
+
+    if (m_use_adk_table) {
+        m_adk_table.resize(h_adk_table.size());
+        amrex::Gpu::copyAsync(amrex::Gpu::hostToDevice, h_adk_table.begin(), h_adk_table.end(),
+                              m_adk_table.begin());
+        amrex::Gpu::streamSynchronize();
     }
 }
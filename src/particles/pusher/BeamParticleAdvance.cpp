@@ -22,7 +22,12 @@ AdvanceBeamParticlesSlice (BeamParticleContainer& beam, Fields& fields, amrex::G
 
     const bool do_z_push = beam.m_do_z_push;
     const int n_subcycles = beam.m_n_subcycles;
-    const amrex::Real dt = Hipace::m_dt / n_subcycles;
+    const bool adaptive_subcycling = beam.m_adaptive_subcycling;
+    const amrex::Real dt_full = Hipace::m_dt;
+    // for adaptive sub-cycling, inverse of the betatron phase advance allowed per sub-step
+    const amrex::Real inv_phase_advance = 1._rt / beam.m_subcycling_phase_advance;
+    // transverse distance below which the focusing strength is not evaluated as E/r
+    const amrex::Real min_radius = 0.5_rt * std::min(dx[0], dx[1]);
 
     // Assumes '2' == 'z' == 'the long dimension'.
     int islice_local = islice - box.smallEnd(2);
@@ -71,11 +76,11 @@ AdvanceBeamParticlesSlice (BeamParticleContainer& beam, Fields& fields, amrex::G
     const amrex::Real zmin = xyzmin[2];
 
     // Declare a DenseBins to pass it to doDepositionShapeN, although it will not be used.
-    BeamBins::index_type*
+    BeamBins::index_type const *
         indices = nullptr;
     BeamBins::index_type const *
         offsets = nullptr;
-    indices = bins.permutationPtr();
+    indices = getBinPermutation(bins, beam);
     offsets = bins.offsetsPtr();
     BeamBins::index_type const
         cell_start = offsets[islice_local], cell_stop = offsets[islice_local+1];
@@ -93,12 +98,42 @@ AdvanceBeamParticlesSlice (BeamParticleContainer& beam, Fields& fields, amrex::G
     amrex::ParallelFor(
         num_particles,
         [=] AMREX_GPU_DEVICE (long idx) {
-            const int ip = indices[cell_start+idx];
+            const int ip = indices ? indices[cell_start+idx] : cell_start+idx;
 
             amrex::ParticleReal xp, yp, zp;
             int pid;
 
-            for (int i = 0; i < n_subcycles; i++) {
+            int n_sub = n_subcycles;
+            if (adaptive_subcycling) {
+                // choose the number of sub-steps from the local betatron frequency,
+                // with the focusing strength estimated from the transverse field at the
+                // particle position, assuming a linear focusing field
+                getPosition(ip, xp, yp, zp, pid);
+                if (pid < 0) return;
+
+                amrex::ParticleReal ExmByp = 0._rt, EypBxp = 0._rt, Ezp = 0._rt;
+                amrex::ParticleReal Bxp = 0._rt, Byp = 0._rt, Bzp = 0._rt;
+                doGatherShapeN(xp, yp, zmin,
+                               ExmByp, EypBxp, Ezp, Bxp, Byp, Bzp,
+                               exmby_arr, eypbx_arr, ez_arr, bx_arr, by_arr, bz_arr,
+                               dx_arr, xyzmin_arr, lo, depos_order_xy, 0);
+                ApplyExternalField(xp, yp, zp, ExmByp, EypBxp, Ezp,
+                                   external_ExmBy_slope, external_Ez_slope, external_Ez_uniform);
+
+                const amrex::ParticleReal gammap = sqrt(
+                    1.0_rt + uxp[ip]*uxp[ip]*clightsq
+                    + uyp[ip]*uyp[ip]*clightsq + uzp[ip]*uzp[ip]*clightsq);
+                const amrex::ParticleReal rp = amrex::max(std::sqrt(xp*xp + yp*yp), min_radius);
+                const amrex::ParticleReal focusing =
+                    std::sqrt(ExmByp*ExmByp + EypBxp*EypBxp) / rp;
+                const amrex::ParticleReal omega_beta =
+                    std::sqrt(std::abs(charge_mass_ratio) * focusing / gammap);
+                n_sub = static_cast<int>(std::ceil(dt_full * omega_beta * inv_phase_advance));
+                n_sub = amrex::min(amrex::max(n_sub, 1), n_subcycles);
+            }
+            const amrex::Real dt = dt_full / n_sub;
+
+            for (int i = 0; i < n_sub; i++) {
 
                 getPosition(ip, xp, yp, zp, pid);
                 if (pid < 0) return;
@@ -10,10 +10,14 @@
 #include "GetAndSetPosition.H"
 #include "utils/HipaceProfilerWrapper.H"
 
+#include <algorithm>
+#include <limits>
+
 void
 AdvancePlasmaParticles (PlasmaParticleContainer& plasma, Fields & fields,
                         amrex::Geometry const& gm, const bool temp_slice, const bool do_push,
-                        const bool do_update, const bool do_shift, int const lev)
+                        const bool do_update, const bool do_shift, int const lev,
+                        amrex::RealBox* disturbed_extent, const amrex::Real disturbed_threshold)
 {
     HIPACE_PROFILE("UpdateForcePushParticles_PlasmaParticleContainer()");
     using namespace amrex::literals;
@@ -24,6 +28,12 @@ AdvancePlasmaParticles (PlasmaParticleContainer& plasma, Fields & fields,
     // Extract properties associated with physical size of the box
     amrex::Real const * AMREX_RESTRICT dx = gm.CellSize();
     const PhysConst phys_const = get_phys_const();
+    const amrex::Real u_threshold_sq =
+        disturbed_threshold*disturbed_threshold*phys_const.c*phys_const.c;
+    // psi is stored in V (SI) or in normalized units
+    const amrex::Real psi_threshold =
+        disturbed_threshold*phys_const.m_e*phys_const.c*phys_const.c/phys_const.q_e;
+    constexpr amrex::Real huge = std::numeric_limits<amrex::Real>::max();
 
     // Loop over particle boxes
     for (PlasmaParticleIterator pti(plasma, lev); pti.isValid(); ++pti)
@@ -116,7 +126,7 @@ AdvancePlasmaParticles (PlasmaParticleContainer& plasma, Fields & fields,
         const amrex::Real charge = plasma.m_charge;
         const amrex::Real mass = plasma.m_mass;
         const bool can_ionize = plasma.m_can_ionize;
-        amrex::ParallelFor(pti.numParticles(),
+        auto advance_particle =
             [=] AMREX_GPU_DEVICE (long ip) {
                 amrex::ParticleReal xp, yp, zp;
                 int pid;
@@ -165,8 +175,37 @@ AdvancePlasmaParticles (PlasmaParticleContainer& plasma, Fields & fields,
                                        dz, temp_slice, ip, SetPosition, enforceBC );
                 }
                 return;
-          }
-          );
+          };
+
+        if (disturbed_extent == nullptr) {
+            amrex::ParallelFor(pti.numParticles(), advance_particle);
+            continue;
+        }
+
+        // Same push, additionally reducing the extent of the disturbed particles after the push
+        amrex::ReduceOps<amrex::ReduceOpMin, amrex::ReduceOpMax,
+                         amrex::ReduceOpMin, amrex::ReduceOpMax> reduce_op;
+        amrex::ReduceData<amrex::Real, amrex::Real, amrex::Real, amrex::Real>
+            reduce_data(reduce_op);
+        using ReduceTuple = typename decltype(reduce_data)::Type;
+        reduce_op.eval(pti.numParticles(), reduce_data,
+            [=] AMREX_GPU_DEVICE (long ip) -> ReduceTuple
+            {
+                advance_particle(ip);
+                amrex::ParticleReal xp, yp, zp;
+                int pid;
+                getPosition(ip, xp, yp, zp, pid);
+                const bool disturbed = pid >= 0 &&
+                    (uxp[ip]*uxp[ip] + uyp[ip]*uyp[ip] > u_threshold_sq ||
+                     std::abs(psip[ip]) > psi_threshold);
+                if (!disturbed) return {huge, -huge, huge, -huge};
+                return {amrex::Real(xp), amrex::Real(xp), amrex::Real(yp), amrex::Real(yp)};
+            });
+        const ReduceTuple result = reduce_data.value();
+        disturbed_extent->setLo(0, std::min(disturbed_extent->lo(0), amrex::get<0>(result)));
+        disturbed_extent->setHi(0, std::max(disturbed_extent->hi(0), amrex::get<1>(result)));
+        disturbed_extent->setLo(1, std::min(disturbed_extent->lo(1), amrex::get<2>(result)));
+        disturbed_extent->setHi(1, std::max(disturbed_extent->hi(1), amrex::get<3>(result)));
       }
 }
 
@@ -179,6 +218,9 @@ ResetPlasmaParticles (PlasmaParticleContainer& plasma, int const lev, const bool
 
     const int init_ion_lev = plasma.m_init_ion_lev;
 
+    // all ions are reset to their initial level, the list of ionizable ions is rebuilt
+    if (initial) plasma.m_ionizable_ids.clear();
+
     // Loop over particle boxes
     for (PlasmaParticleIterator pti(plasma, lev); pti.isValid(); ++pti)
     {
@@ -0,0 +1,165 @@
+#include "BenchmarkMode.H"
+
+#include <AMReX_OpenMP.H>
+#include <AMReX_ParallelDescriptor.H>
+#include <AMReX_ParmParse.H>
+#include <AMReX_Print.H>
+
+#include <iomanip>
+#include <string>
+#include <vector>
+
+namespace
+{
+    /** \brief Adds a parameter to the ParmParse table, unless the user specified it
+     * \param[in] pp ParmParse with the prefix of the parameter
+     * \param[in] name name of the parameter
+     * \param[in] value default value
+     */
+    template<typename T>
+    void AddDefault (amrex::ParmParse& pp, const std::string& name, const T& value)
+    {
+        if (!pp.contains(name.c_str())) pp.add(name.c_str(), value);
+    }
+
+    /** Array version of AddDefault */
+    template<typename T>
+    void AddDefaultArr (amrex::ParmParse& pp, const std::string& name,
+                        const std::vector<T>& value)
+    {
+        if (!pp.contains(name.c_str())) pp.addarr(name.c_str(), value);
+    }
+}
+
+bool
+BenchmarkMode::Setup ()
+{
+    amrex::ParmParse pph("hipace");
+    bool benchmark_mode = false;
+    pph.query("benchmark_mode", benchmark_mode);
+    if (!benchmark_mode) return false;
+
+    amrex::ParmParse ppb("benchmark");
+    std::vector<int> n_cell {64, 64, 128};
+    std::vector<int> plasma_ppc {1, 1};
+    std::vector<int> beam_ppc {1, 1, 1};
+    long beam_num_particles = 0;
+    int num_steps = 10;
+    ppb.queryarr("n_cell", n_cell);
+    ppb.queryarr("plasma_ppc", plasma_ppc);
+    ppb.queryarr("beam_ppc", beam_ppc);
+    ppb.query("beam_num_particles", beam_num_particles);
+    ppb.query("num_steps", num_steps);
+
+    // amr.n_cell takes precedence over benchmark.n_cell, the domain is built on the grid in effect
+    amrex::ParmParse ppa("amr");
+    AddDefaultArr(ppa, "n_cell", n_cell);
+    ppa.getarr("n_cell", n_cell);
+
+    int numprocs_x = 1, numprocs_y = 1;
+    pph.query("numprocs_x", numprocs_x);
+    pph.query("numprocs_y", numprocs_y);
+    const int numprocs_z = amrex::ParallelDescriptor::NProcs() / (numprocs_x*numprocs_y);
+    AMREX_ALWAYS_ASSERT_WITH_MESSAGE(num_steps >= numprocs_z,
+        "benchmark.num_steps must be at least the number of ranks in z to fill the pipeline");
+    AMREX_ALWAYS_ASSERT_WITH_MESSAGE(n_cell[2] % numprocs_z == 0,
+        "The number of cells in z must be a multiple of the number of ranks in z");
+
+    // Fixed cell size in normalized units, so the domain grows with the number of cells
+    const double dx = 0.25, dz = 0.1;
+    const double lx = n_cell[0]*dx, ly = n_cell[1]*dx, lz = n_cell[2]*dz;
+
+    amrex::ParmParse pp;
+    AddDefault(pp, "max_step", num_steps - 1);
+    AddDefault(ppa, "max_level", 0);
+    AddDefault(ppa, "blocking_factor", 2);
+    amrex::ParmParse ppg("geometry");
+    AddDefault(ppg, "coord_sys", 0);
+    AddDefaultArr(ppg, "is_periodic", std::vector<int>{1, 1, 0});
+    AddDefaultArr(ppg, "prob_lo", std::vector<double>{-lx/2., -ly/2., -lz/2.});
+    AddDefaultArr(ppg, "prob_hi", std::vector<double>{lx/2., ly/2., lz/2.});
+
+    AddDefault(pph, "normalized_units", 1);
+    AddDefault(pph, "dt", 10.);
+    AddDefault(pph, "predcorr_max_iterations", 1);
+    AddDefault(pph, "predcorr_B_mixing_factor", 0.12);
+    AddDefault(pph, "predcorr_B_error_tolerance", -1.);
+
+    amrex::ParmParse ppp("plasmas");
+    AddDefault(ppp, "names", std::string("plasma"));
+    amrex::ParmParse ppplasma("plasma");
+    AddDefault(ppplasma, "density", 1.);
+    AddDefaultArr(ppplasma, "ppc", plasma_ppc);
+    AddDefaultArr(ppplasma, "u_mean", std::vector<double>{0., 0., 0.});
+    AddDefault(ppplasma, "element", std::string("electron"));
+
+    // Gaussian beam in the middle of the domain, with a fixed number of particles per cell or a
+    // fixed number of particles
+    amrex::ParmParse ppbeams("beams");
+    AddDefault(ppbeams, "names", std::string("beam"));
+    amrex::ParmParse ppbeam("beam");
+    AddDefault(ppbeam, "profile", std::string("gaussian"));
+    AddDefault(ppbeam, "density", 3.);
+    AddDefaultArr(ppbeam, "u_mean", std::vector<double>{0., 0., 2000.});
+    AddDefaultArr(ppbeam, "u_std", std::vector<double>{0., 0., 0.});
+    AddDefaultArr(ppbeam, "position_mean", std::vector<double>{0., 0., 0.});
+    AddDefaultArr(ppbeam, "position_std", std::vector<double>{0.3, 0.3, lz/8.});
+    if (beam_num_particles > 0) {
+        AddDefault(ppbeam, "injection_type", std::string("fixed_weight"));
+        AddDefault(ppbeam, "num_particles", beam_num_particles);
+    } else {
+        AddDefault(ppbeam, "injection_type", std::string("fixed_ppc"));
+        AddDefaultArr(ppbeam, "ppc", beam_ppc);
+        AddDefault(ppbeam, "zmin", -0.49*lz);
+        AddDefault(ppbeam, "zmax", 0.49*lz);
+        AddDefault(ppbeam, "radius", 1.2);
+    }
+
+    // No I/O: the last definition of a parameter is the one used
+    pph.add("output_period", -1);
+    pph.add("checkpoint_period", -1);
+    amrex::ParmParse ppd("diagnostic");
+    ppd.add("reduced_period", -1);
+
+    amrex::Print() << "Benchmark mode: " << n_cell[0] << "x" << n_cell[1] << "x" << n_cell[2]
+                   << " cells, " << num_steps << " steps, diagnostics disabled\n";
+    return true;
+}
+
+void
+BenchmarkMode::Report (const double evolve_time, const int nsteps, const amrex::Box& domain,
+                       const int numprocs_z)
+{
+    double wall_time = evolve_time;
+    amrex::ParallelDescriptor::ReduceRealMax(wall_time);
+    double reference = 0.;
+    amrex::ParmParse ppb("benchmark");
+    ppb.query("reference_throughput", reference);
+
+    const int nprocs = amrex::ParallelDescriptor::NProcs();
+    const double slices = static_cast<double>(nsteps) * domain.length(2);
+    const double cells_per_slice = static_cast<double>(domain.length(0)) * domain.length(1);
+    const double slice_rate = wall_time > 0. ? slices/wall_time : 0.;
+    // throughput per rank in transverse cells times slices: the same for ideal strong and weak
+    // scaling, so its ratio to the reference run is the parallel efficiency
+    const double cell_rate_per_rank = slice_rate*cells_per_slice/nprocs;
+    const std::string efficiency = reference > 0. ?
+        std::to_string(cell_rate_per_rank/reference) : "n/a";
+
+    amrex::Print() << std::setprecision(6)
+                   << "\nBenchmark: " << nprocs << " ranks (" << numprocs_z << " in z), "
+                   << amrex::OpenMP::get_max_threads() << " threads per rank, grid "
+                   << domain.length(0) << "x" << domain.length(1) << "x" << domain.length(2)
+                   << ", " << nsteps << " steps\n"
+                   << "  Evolve wall time [s]                " << wall_time << "\n"
+                   << "  slices per second                   " << slice_rate << "\n"
+                   << "  cell-slices per second per rank     " << cell_rate_per_rank << "\n"
+                   << "  parallel efficiency                 " << efficiency << "\n"
+                   // one line per run, to collect scaling sweeps with grep
+                   << "BENCHMARK nprocs=" << nprocs << " numprocs_z=" << numprocs_z
+                   << " nthreads=" << amrex::OpenMP::get_max_threads()
+                   << " n_cell=" << domain.length(0) << "," << domain.length(1) << ","
+                   << domain.length(2) << " time=" << wall_time << " slices_per_s=" << slice_rate
+                   << " cell_slices_per_s_per_rank=" << cell_rate_per_rank
+                   << " efficiency=" << efficiency << "\n";
+}
@@ -3,27 +3,227 @@
 #include "HipaceProfilerWrapper.H"
 #include "Constants.H"
 
+#include <AMReX_GpuContainers.H>
+#include <AMReX_ParallelDescriptor.H>
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+namespace
+{
+    /** \brief Reads a text file on the IO rank, broadcasts it and removes the comment lines
+     * (starting with #)
+     *
+     * \param[in] filename name of the file
+     */
+    std::string ReadTable (const std::string& filename)
+    {
+        amrex::Vector<char> file_chars;
+        amrex::ParallelDescriptor::ReadAndBcastFile(filename, file_chars);
+        std::istringstream is(file_chars.dataPtr(), std::istringstream::in);
+        std::string content, line;
+        while (std::getline(is, line)) {
+            const auto first = line.find_first_not_of(" \t");
+            if (first == std::string::npos || line[first] == '#') continue;
+            content += line + "\n";
+        }
+        return content;
+    }
+}
+
 GridCurrent::GridCurrent ()
 {
     amrex::ParmParse pp("grid_current");
 
     if (pp.query("use_grid_current", m_use_grid_current) ) {
-        pp.get("peak_current_density", m_peak_current_density);
-        amrex::Array<amrex::Real, AMREX_SPACEDIM> loc_array;
-        pp.get("position_mean", loc_array);
-        for (int idim=0; idim < AMREX_SPACEDIM; ++idim) m_position_mean[idim] = loc_array[idim];
-        pp.get("position_std", loc_array);
-        for (int idim=0; idim < AMREX_SPACEDIM; ++idim) m_position_std[idim] = loc_array[idim];
+        std::string longitudinal_profile = "gaussian";
+        std::string transverse_profile = "gaussian";
+        pp.query("longitudinal_profile", longitudinal_profile);
+        pp.query("transverse_profile", transverse_profile);
+        AMREX_ALWAYS_ASSERT_WITH_MESSAGE(
+            longitudinal_profile == "gaussian" || longitudinal_profile == "from_file",
+            "grid_current.longitudinal_profile must be gaussian or from_file");
+        AMREX_ALWAYS_ASSERT_WITH_MESSAGE(
+            transverse_profile == "gaussian" || transverse_profile == "from_file",
+            "grid_current.transverse_profile must be gaussian or from_file");
+        m_longitudinal_from_file = longitudinal_profile == "from_file";
+        m_transverse_from_file = transverse_profile == "from_file";
+
+        // the Gaussian profiles need the mean position and the width
+        if (!m_longitudinal_from_file || !m_transverse_from_file) {
+            amrex::Array<amrex::Real, AMREX_SPACEDIM> loc_array;
+            pp.get("position_mean", loc_array);
+            for (int idim=0; idim < AMREX_SPACEDIM; ++idim) m_position_mean[idim] = loc_array[idim];
+            pp.get("position_std", loc_array);
+            for (int idim=0; idim < AMREX_SPACEDIM; ++idim) m_position_std[idim] = loc_array[idim];
+        }
+
+        if (m_longitudinal_from_file) {
+            std::string current_file;
+            pp.get("current_file", current_file);
+            ReadCurrentFile(current_file);
+        } else {
+            pp.get("peak_current_density", m_peak_current_density);
+        }
+        if (m_transverse_from_file) {
+            std::string transverse_file;
+            pp.get("transverse_file", transverse_file);
+            ReadTransverseFile(transverse_file);
+        }
         pp.query("finest_level", m_finest_level);
+        m_transverse_profile.resize(m_finest_level+1);
+    }
+}
+
+void
+GridCurrent::ReadCurrentFile (const std::string& filename)
+{
+    std::istringstream is(ReadTable(filename));
+    amrex::Real z, current;
+    while (is >> z >> current) {
+        AMREX_ALWAYS_ASSERT_WITH_MESSAGE(m_table_z.empty() || z > m_table_z.back(),
+            "The positions in grid_current.current_file " + filename + " must be increasing");
+        m_table_z.push_back(z);
+        m_table_current.push_back(current);
+    }
+    AMREX_ALWAYS_ASSERT_WITH_MESSAGE(m_table_z.size() >= 2,
+        "grid_current.current_file " + filename + " must contain at least two lines z I");
+}
+
+void
+GridCurrent::ReadTransverseFile (const std::string& filename)
+{
+    std::istringstream is(ReadTable(filename));
+    is >> m_table_n[0] >> m_table_n[1] >> m_table_lo[0] >> m_table_hi[0] >> m_table_lo[1]
+       >> m_table_hi[1];
+    AMREX_ALWAYS_ASSERT_WITH_MESSAGE(!is.fail() && m_table_n[0] >= 2 && m_table_n[1] >= 2 &&
+        m_table_hi[0] > m_table_lo[0] && m_table_hi[1] > m_table_lo[1],
+        "The header of grid_current.transverse_file " + filename +
+        " must be nx ny xmin xmax ymin ymax, with at least two points in x and y");
+    m_table_transverse.resize(m_table_n[0]*m_table_n[1]);
+    for (auto& value : m_table_transverse) is >> value;
+    AMREX_ALWAYS_ASSERT_WITH_MESSAGE(!is.fail(), "grid_current.transverse_file " + filename +
+                                     " must contain nx*ny values after the header");
+}
+
+void
+GridCurrent::BuildTransverseProfile (const amrex::Box& box, const amrex::Geometry& geom,
+                                     const int lev)
+{
+    HIPACE_PROFILE("GridCurrent::BuildTransverseProfile()");
+    using namespace amrex::literals;
+
+    m_transverse_profile[lev] = std::make_unique<amrex::FArrayBox>(box, 1);
+    amrex::Array4<amrex::Real> const& profile_arr = m_transverse_profile[lev]->array();
+
+    const auto plo = geom.ProbLoArray();
+    amrex::Real const * AMREX_RESTRICT dx = geom.CellSize();
+    const amrex::GpuArray<amrex::Real, 3> dx_arr = {dx[0], dx[1], dx[2]};
+
+    // With a tabulated current I(z), the transverse profile is normalized to a unit integral.
+    // Otherwise, it is scaled by the peak current density.
+    amrex::Real scale = m_peak_current_density;
+
+    if (m_transverse_from_file) {
+        const int nx = m_table_n[0];
+        const int ny = m_table_n[1];
+        const amrex::Real xlo = m_table_lo[0];
+        const amrex::Real ylo = m_table_lo[1];
+        const amrex::Real hx = (m_table_hi[0] - m_table_lo[0])/(nx - 1);
+        const amrex::Real hy = (m_table_hi[1] - m_table_lo[1])/(ny - 1);
+        if (m_longitudinal_from_file) {
+            // trapezoidal integral of the table
+            amrex::Real integral = 0.;
+            for (int j = 0; j < ny; ++j) {
+                for (int i = 0; i < nx; ++i) {
+                    const amrex::Real wx = (i == 0 || i == nx-1) ? 0.5 : 1.;
+                    const amrex::Real wy = (j == 0 || j == ny-1) ? 0.5 : 1.;
+                    integral += wx*wy*m_table_transverse[i + j*nx];
+                }
+            }
+            integral *= hx*hy;
+            AMREX_ALWAYS_ASSERT_WITH_MESSAGE(integral != 0.,
+                "The profile in grid_current.transverse_file has a zero integral");
+            scale = 1./integral;
+        }
+
+        amrex::Gpu::DeviceVector<amrex::Real> table(m_table_transverse.size());
+        amrex::Gpu::copy(amrex::Gpu::hostToDevice, m_table_transverse.begin(),
+                         m_table_transverse.end(), table.begin());
+        const amrex::Real * const table_ptr = table.dataPtr();
+
+        // bilinear interpolation at the cell centers, zero outside of the table
+        amrex::ParallelFor(box,
+        [=] AMREX_GPU_DEVICE(int i, int j, int k)
+        {
+            const amrex::Real x = plo[0] + (i+0.5_rt)*dx_arr[0];
+            const amrex::Real y = plo[1] + (j+0.5_rt)*dx_arr[1];
+            const amrex::Real fx = (x - xlo)/hx;
+            const amrex::Real fy = (y - ylo)/hy;
+            if (fx < 0._rt || fx > nx-1 || fy < 0._rt || fy > ny-1) {
+                profile_arr(i, j, k) = 0._rt;
+                return;
+            }
+            const int ix = amrex::min(static_cast<int>(fx), nx-2);
+            const int iy = amrex::min(static_cast<int>(fy), ny-2);
+            const amrex::Real wx = fx - ix;
+            const amrex::Real wy = fy - iy;
+            const amrex::Real value =
+                (1._rt-wx)*(1._rt-wy)*table_ptr[ix   +  iy   *nx]
+                +      wx *(1._rt-wy)*table_ptr[ix+1 +  iy   *nx]
+                + (1._rt-wx)*     wy *table_ptr[ix   + (iy+1)*nx]
+                +      wx *     wy *table_ptr[ix+1 + (iy+1)*nx];
+            profile_arr(i, j, k) = scale*value;
+        });
+        amrex::Gpu::streamSynchronize();
+    } else {
+        if (m_longitudinal_from_file) {
+            scale = 1._rt/(2._rt*MathConst::pi*m_position_std[0]*m_position_std[1]);
+        }
+        const amrex::GpuArray<amrex::Real, 2> pos_mean = {m_position_mean[0],
+                                                          m_position_mean[1]};
+        const amrex::GpuArray<amrex::Real, 2> pos_std = {m_position_std[0], m_position_std[1]};
+
+        amrex::ParallelFor(box,
+        [=] AMREX_GPU_DEVICE(int i, int j, int k)
+        {
+            const amrex::Real x = plo[0] + (i+0.5_rt)*dx_arr[0];
+            const amrex::Real y = plo[1] + (j+0.5_rt)*dx_arr[1];
+
+            const amrex::Real delta_x = (x - pos_mean[0]) / pos_std[0];
+            const amrex::Real delta_y = (y - pos_mean[1]) / pos_std[1];
+            const amrex::Real trans_pos_factor =  std::exp( -0.5_rt*(delta_x*delta_x
+                                                                    + delta_y*delta_y) );
+            profile_arr(i, j, k) = scale*trans_pos_factor;
+        });
     }
 }
 
+amrex::Real
+GridCurrent::LongitudinalFactor (const amrex::Real z) const
+{
+    using namespace amrex::literals;
+
+    if (!m_longitudinal_from_file) {
+        const amrex::Real delta_z = (z - m_position_mean[2]) / m_position_std[2];
+        return std::exp( -0.5_rt*(delta_z*delta_z) );
+    }
+
+    // linear interpolation of I(z), zero outside of the table
+    if (z < m_table_z.front() || z > m_table_z.back()) return 0._rt;
+    const int i = std::min(static_cast<int>(
+        std::upper_bound(m_table_z.begin(), m_table_z.end(), z) - m_table_z.begin()),
+        static_cast<int>(m_table_z.size()) - 1);
+    const amrex::Real w = (z - m_table_z[i-1])/(m_table_z[i] - m_table_z[i-1]);
+    return (1._rt - w)*m_table_current[i-1] + w*m_table_current[i];
+}
+
 void
 GridCurrent::DepositCurrentSlice (Fields& fields, const amrex::Geometry& geom, int const lev,
                                   const int islice)
 {
     HIPACE_PROFILE("GridCurrent::DepositCurrentSlice()");
-    using namespace amrex::literals;
 
     if (m_use_grid_current == 0) return;
 
@@ -33,11 +233,9 @@ GridCurrent::DepositCurrentSlice (Fields& fields, const amrex::Geometry& geom, i
     const auto plo = geom.ProbLoArray();
     amrex::Real const * AMREX_RESTRICT dx = geom.CellSize();
 
-    const amrex::GpuArray<amrex::Real, 3> pos_mean = {m_position_mean[0], m_position_mean[1],
-                                                      m_position_mean[2]};
-    const amrex::GpuArray<amrex::Real, 3> pos_std = {m_position_std[0], m_position_std[1],
-                                                     m_position_std[2]};
-    const amrex::GpuArray<amrex::Real, 3> dx_arr = {dx[0], dx[1], dx[2]};
+    const amrex::Real z = plo[2] + islice*dx[2];
+    const amrex::Real long_pos_factor = LongitudinalFactor(z);
+    if (long_pos_factor == 0.) return;
 
     // Extract the longitudinal beam current
     amrex::MultiFab& S = fields.getSlices(lev, WhichSlice::This);
@@ -46,10 +244,11 @@ GridCurrent::DepositCurrentSlice (Fields& fields, const amrex::Geometry& geom, i
     // Extract FabArray for this box
     amrex::FArrayBox& jz_fab = jz[0];
 
-    const amrex::Real z = plo[2] + islice*dx_arr[2];
-    const amrex::Real delta_z = (z - pos_mean[2]) / pos_std[2];
-    const amrex::Real long_pos_factor =  std::exp( -0.5_rt*(delta_z*delta_z) );
-    const amrex::Real loc_peak_current_density = m_peak_current_density;
+    // The transverse profile is computed on the first slice only
+    if (!m_transverse_profile[lev] || m_transverse_profile[lev]->box() != jz_fab.box()) {
+        BuildTransverseProfile(jz_fab.box(), geom, lev);
+    }
+    amrex::Array4<amrex::Real const> const& profile_arr = m_transverse_profile[lev]->const_array();
 
     for ( amrex::MFIter mfi(S, amrex::TilingIfNotGPU()); mfi.isValid(); ++mfi ){
         const amrex::Box& bx = mfi.tilebox();
@@ -58,15 +257,7 @@ GridCurrent::DepositCurrentSlice (Fields& fields, const amrex::Geometry& geom, i
         amrex::ParallelFor( bx,
         [=] AMREX_GPU_DEVICE(int i, int j, int k)
         {
-            const amrex::Real x = plo[0] + (i+0.5_rt)*dx_arr[0];
-            const amrex::Real y = plo[1] + (j+0.5_rt)*dx_arr[1];
-
-            const amrex::Real delta_x = (x - pos_mean[0]) / pos_std[0];
-            const amrex::Real delta_y = (y - pos_mean[1]) / pos_std[1];
-            const amrex::Real trans_pos_factor =  std::exp( -0.5_rt*(delta_x*delta_x
-                                                                    + delta_y*delta_y) );
-
-            jz_arr(i, j, k) += loc_peak_current_density*trans_pos_factor*long_pos_factor;
+            jz_arr(i, j, k) += long_pos_factor*profile_arr(i, j, k);
         });
     }
 }
@@ -0,0 +1,128 @@
+#include "HipaceTracer.H"
+
+#include <AMReX_OpenMP.H>
+#include <AMReX_ParallelDescriptor.H>
+#include <AMReX_Print.H>
+#include <AMReX_Utility.H>
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+bool HipaceTracer::m_enabled = false;
+amrex::Vector<HipaceTracer::Event> HipaceTracer::m_events;
+double HipaceTracer::m_t0 = 0.;
+std::string HipaceTracer::m_filename;
+int HipaceTracer::m_rank_z = 0;
+int HipaceTracer::m_max_events = 0;
+
+void
+HipaceTracer::Enable (const std::string& filename, const int rank_z, const int max_events)
+{
+    m_filename = filename;
+    m_rank_z = rank_z;
+    m_max_events = max_events;
+    m_events.clear();
+    m_events.reserve(std::min(max_events, 1 << 16));
+    amrex::ParallelDescriptor::Barrier();
+    m_t0 = amrex::second();
+    m_enabled = true;
+}
+
+void
+HipaceTracer::AddEvent (const char* name, const double start, const double end)
+{
+    if (static_cast<int>(m_events.size()) >= m_max_events) return;
+    m_events.push_back({name, start - m_t0, end - start});
+}
+
+void
+HipaceTracer::WriteTrace ()
+{
+    if (!m_enabled) return;
+    m_enabled = false;
+
+    // Events of this rank, in microseconds, as a comma-separated list of JSON objects
+    const int rank = amrex::ParallelDescriptor::MyProc();
+    std::ostringstream ss;
+    ss << std::fixed << std::setprecision(3);
+    ss << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << rank
+       << ",\"args\":{\"name\":\"rank " << rank << " (rank_z " << m_rank_z << ")\"}},\n"
+       << "{\"name\":\"process_sort_index\",\"ph\":\"M\",\"pid\":" << rank
+       << ",\"args\":{\"sort_index\":" << rank << "}}";
+    for (const auto& e : m_events) {
+        ss << ",\n{\"name\":\"" << e.name << "\",\"ph\":\"X\",\"pid\":" << rank
+           << ",\"tid\":0,\"ts\":" << e.start*1.e6 << ",\"dur\":" << e.duration*1.e6 << "}";
+    }
+    if (static_cast<int>(m_events.size()) >= m_max_events) {
+        amrex::AllPrint() << "WARNING: rank " << rank << " reached hipace.trace_max_events = "
+                          << m_max_events << ", the trace is truncated\n";
+    }
+    m_events.clear();
+    m_events.shrink_to_fit();
+    const std::string local = ss.str();
+
+    // Stream the events of each rank to the IO rank, which writes them in rank order. The
+    // size is sent as a 64-bit integer and the data in chunks that fit in the int count of MPI,
+    // so neither the trace of a rank nor the total is limited to INT_MAX characters.
+    const int root = amrex::ParallelDescriptor::IOProcessorNumber();
+    const int nprocs = amrex::ParallelDescriptor::NProcs();
+    const bool is_root = amrex::ParallelDescriptor::IOProcessor();
+    constexpr long long max_chunk = 1 << 30;
+    std::ofstream ofs;
+    if (is_root) {
+        ofs.open(m_filename);
+        if (!ofs.good()) amrex::FileOpenFailed(m_filename);
+        ofs << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    }
+    for (int i = 0; i < nprocs; ++i) {
+        if (is_root && i > 0) ofs << ",\n";
+        if (i == root) {
+            if (is_root) ofs.write(local.data(), local.size());
+            continue;
+        }
+#ifdef AMREX_USE_MPI
+        const MPI_Comm comm = amrex::ParallelDescriptor::Communicator();
+        if (rank == i) {
+            long long size = local.size();
+            MPI_Send(&size, 1, MPI_LONG_LONG, root, 0, comm);
+            for (long long pos = 0; pos < size; pos += max_chunk) {
+                const int count = static_cast<int>(std::min(max_chunk, size - pos));
+                MPI_Send(local.data() + pos, count, MPI_CHAR, root, 0, comm);
+            }
+        } else if (is_root) {
+            long long size = 0;
+            MPI_Recv(&size, 1, MPI_LONG_LONG, i, 0, comm, MPI_STATUS_IGNORE);
+            amrex::Vector<char> buffer(std::min(max_chunk, size));
+            for (long long pos = 0; pos < size; pos += max_chunk) {
+                const int count = static_cast<int>(std::min(max_chunk, size - pos));
+                MPI_Recv(buffer.dataPtr(), count, MPI_CHAR, i, 0, comm, MPI_STATUS_IGNORE);
+                ofs.write(buffer.dataPtr(), count);
+            }
+        }
+#endif
+    }
+
+    if (!is_root) return;
+    ofs << "\n]}\n";
+    ofs.close();
+    AMREX_ALWAYS_ASSERT_WITH_MESSAGE(!ofs.fail(), "Failed to write " + m_filename);
+    amrex::Print() << "Timeline trace written to " << m_filename << "\n";
+}
+
+void
+TraceRegion::start ()
+{
+    // only the master thread records, the regions are not nested in OpenMP parallel regions
+    if (!HipaceTracer::m_enabled || amrex::OpenMP::get_thread_num() != 0) return;
+    m_start = amrex::second();
+}
+
+void
+TraceRegion::stop ()
+{
+    if (m_start < 0.) return;
+    HipaceTracer::AddEvent(m_name, m_start, amrex::second());
+    m_start = -1.;
+}
@@ -0,0 +1,64 @@
+#include "MemoryReport.H"
+
+#include <AMReX_GpuDevice.H>
+#include <AMReX_ParallelDescriptor.H>
+#include <AMReX_Print.H>
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+namespace
+{
+    /** Size in MiB, for printing */
+    double MiB (const amrex::Long bytes) { return bytes / (1024.*1024.); }
+}
+
+void
+MemoryReport::Record (const std::string& category, const amrex::Long bytes)
+{
+    for (auto& entry : m_entries) {
+        if (entry.name == category) {
+            entry.current = bytes;
+            entry.high_water = std::max(entry.high_water, bytes);
+            return;
+        }
+    }
+    m_entries.push_back({category, bytes, bytes});
+}
+
+void
+MemoryReport::Print (const std::string& title, const bool reduce) const
+{
+    const int n = m_entries.size();
+    amrex::Vector<amrex::Long> values(2*n+2, 0);
+    for (int i = 0; i < n; ++i) {
+        values[2*i] = m_entries[i].current;
+        values[2*i+1] = m_entries[i].high_water;
+        values[2*n] += m_entries[i].current;
+        values[2*n+1] += m_entries[i].high_water;
+    }
+    if (reduce) {
+        amrex::ParallelDescriptor::ReduceLongMax(values.dataPtr(), values.size(),
+                                                 amrex::ParallelDescriptor::IOProcessorNumber());
+        if (!amrex::ParallelDescriptor::IOProcessor()) return;
+    }
+
+    std::ostringstream table;
+    table << title << (reduce ? " (maximum over ranks)" : "") << "\n"
+          << "  " << std::left << std::setw(48) << "category" << std::right << std::setw(14)
+          << "current [MiB]" << std::setw(14) << "high-water" << "\n" << std::fixed
+          << std::setprecision(2);
+    for (int i = 0; i < n; ++i) {
+        table << "  " << std::left << std::setw(48) << m_entries[i].name << std::right
+              << std::setw(14) << MiB(values[2*i]) << std::setw(14) << MiB(values[2*i+1])
+              << "\n";
+    }
+    table << "  " << std::left << std::setw(48) << "total (sum of the above)" << std::right
+          << std::setw(14) << MiB(values[2*n]) << std::setw(14) << MiB(values[2*n+1]) << "\n";
+#ifdef AMREX_USE_GPU
+    table << "  device memory free / total [MiB]: " << MiB(amrex::Gpu::Device::freeMemAvailable())
+          << " / " << MiB(amrex::Gpu::Device::totalGlobalMem()) << "\n";
+#endif
+    amrex::AllPrint() << table.str();
+}
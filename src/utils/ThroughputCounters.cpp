@@ -0,0 +1,46 @@
+#include "ThroughputCounters.H"
+
+#include <AMReX_ParallelDescriptor.H>
+#include <AMReX_Print.H>
+
+#include <iomanip>
+#include <sstream>
+
+void
+ThroughputCounters::Report (const long plasma_pushes, const long beam_pushes,
+                            const amrex::Vector<long>& poisson_solves,
+                            const amrex::Vector<std::string>& poisson_sizes) const
+{
+    if (!m_report) return;
+
+    // counts are summed over ranks, the rates use the wall time of the slowest rank
+    const int nlev = poisson_solves.size();
+    amrex::Vector<long> counts {plasma_pushes, beam_pushes, m_predcorr_iterations,
+                                m_predcorr_slices, m_bytes_sent, m_num_waits};
+    counts.insert(counts.end(), poisson_solves.begin(), poisson_solves.end());
+    amrex::ParallelDescriptor::ReduceLongSum(counts.dataPtr(), counts.size());
+    double wall_time = m_evolve_time;
+    amrex::ParallelDescriptor::ReduceRealMax(wall_time);
+    double wait_time = m_wait_time;
+    amrex::ParallelDescriptor::ReduceRealSum(wait_time);
+
+    const auto rate = [wall_time] (const long n) { return wall_time > 0. ? n/wall_time : 0.; };
+    std::ostringstream table;
+    const auto line = [&table] (const std::string& name) -> std::ostream& {
+        return table << "  " << std::left << std::setw(48) << name << std::right << std::setw(14);
+    };
+
+    table << "\nThroughput (summed over " << amrex::ParallelDescriptor::NProcs()
+          << " ranks, Evolve wall time " << wall_time << " s)\n";
+    line("plasma particle-slices pushed per second") << rate(counts[0]) << "\n";
+    line("beam particle pushes per second") << rate(counts[1]) << "\n";
+    for (int lev = 0; lev < nlev; ++lev) {
+        line("Poisson solves per second, level " + std::to_string(lev) + " (" +
+             poisson_sizes[lev] + ")") << rate(counts[6+lev]) << "\n";
+    }
+    line("predictor-corrector iterations per slice")
+        << (counts[3] > 0 ? static_cast<double>(counts[2])/counts[3] : 0.) << "\n";
+    line("bytes sent in Notify") << counts[4] << "\n";
+    line("average Wait time [s]") << (counts[5] > 0 ? wait_time/counts[5] : 0.) << "\n";
+    amrex::Print() << table.str();
+}
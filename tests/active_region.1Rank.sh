@@ -0,0 +1,35 @@
+#! /usr/bin/env bash
+
+# This file is part of the HiPACE++ test suite.
+# It runs the linear_wake.normalized.1Rank simulation with the sources restricted to the active
+# region. With a low threshold, the region contains all the plasma that is disturbed enough to
+# matter, so the result must match the benchmark of the full-slice run.
+
+# abort on first encounted error
+set -eu -o pipefail
+
+# Read input parameters
+HIPACE_EXECUTABLE=$1
+HIPACE_SOURCE_DIR=$2
+
+HIPACE_EXAMPLE_DIR=${HIPACE_SOURCE_DIR}/examples/linear_wake
+HIPACE_TEST_DIR=${HIPACE_SOURCE_DIR}/tests
+
+FILE_NAME=`basename "$0"`
+TEST_NAME="${FILE_NAME%.*}"
+
+# Run the simulation
+mpiexec -n 1 $HIPACE_EXECUTABLE $HIPACE_EXAMPLE_DIR/inputs_normalized \
+        hipace.use_active_region = 1 \
+        hipace.active_region_threshold = 1.e-6 \
+        hipace.file_prefix=$TEST_NAME
+
+# Compare the result with theory
+$HIPACE_EXAMPLE_DIR/analysis.py --normalized-units --output-dir=$TEST_NAME
+
+# Compare the results with the checksum benchmark of the full-slice run
+$HIPACE_TEST_DIR/checksum/checksumAPI.py \
+    --evaluate \
+    --file_name $TEST_NAME \
+    --test-name linear_wake.normalized.1Rank \
+    --rtol 1.e-4
@@ -0,0 +1,58 @@
+#! /usr/bin/env bash
+
+# This file is part of the HiPACE++ test suite.
+# It runs a low-energy beam in an external focusing field, once with uniform sub-cycling
+# and once with adaptive sub-cycling, and checks that both runs converge to the same result.
+
+# abort on first encounted error
+set -eu -o pipefail
+
+# Read input parameters
+HIPACE_EXECUTABLE=$1
+HIPACE_SOURCE_DIR=$2
+
+HIPACE_EXAMPLE_DIR=${HIPACE_SOURCE_DIR}/examples/beam_in_vacuum
+HIPACE_TEST_DIR=${HIPACE_SOURCE_DIR}/tests
+
+FILE_NAME=`basename "$0"`
+TEST_NAME="${FILE_NAME%.*}"
+
+rm -rf ${TEST_NAME}_uniform ${TEST_NAME}_adaptive
+
+# Run the simulation with uniform sub-cycling
+mpiexec -n 1 $HIPACE_EXECUTABLE $HIPACE_EXAMPLE_DIR/inputs_normalized \
+        amr.n_cell = 32 32 10 \
+        max_step = 20 \
+        geometry.prob_lo = -2. -2. -2. \
+        geometry.prob_hi =  2.  2.  2. \
+        hipace.dt = 3. \
+        hipace.output_period = 20 \
+        beam.density = 1.e-8 \
+        beam.radius = 1. \
+        beam.ppc = 4 4 1 \
+        beam.u_mean = 0. 0. 10. \
+        beam.n_subcycles = 40 \
+        hipace.external_ExmBy_slope = .5 \
+        hipace.file_prefix = ${TEST_NAME}_uniform
+
+# Run the simulation with adaptive sub-cycling
+mpiexec -n 1 $HIPACE_EXECUTABLE $HIPACE_EXAMPLE_DIR/inputs_normalized \
+        amr.n_cell = 32 32 10 \
+        max_step = 20 \
+        geometry.prob_lo = -2. -2. -2. \
+        geometry.prob_hi =  2.  2.  2. \
+        hipace.dt = 3. \
+        hipace.output_period = 20 \
+        beam.density = 1.e-8 \
+        beam.radius = 1. \
+        beam.ppc = 4 4 1 \
+        beam.u_mean = 0. 0. 10. \
+        beam.n_subcycles = 40 \
+        beam.adaptive_subcycling = 1 \
+        beam.subcycling_phase_advance = 0.05 \
+        hipace.external_ExmBy_slope = .5 \
+        hipace.file_prefix = ${TEST_NAME}_adaptive
+
+# Compare the two runs
+$HIPACE_EXAMPLE_DIR/analysis_subcycling.py --uniform-dir=${TEST_NAME}_uniform \
+                                           --adaptive-dir=${TEST_NAME}_adaptive
@@ -0,0 +1,56 @@
+#! /usr/bin/env bash
+
+# This file is part of the HiPACE++ test suite.
+# It runs the blowout wake in normalized units on 2 ranks with the openPMD output written
+# synchronously and by the asynchronous IO thread, and checks that both outputs are identical.
+
+# abort on first encounted error
+set -eu -o pipefail
+
+# Read input parameters
+HIPACE_EXECUTABLE=$1
+HIPACE_SOURCE_DIR=$2
+
+HIPACE_EXAMPLE_DIR=${HIPACE_SOURCE_DIR}/examples/blowout_wake
+HIPACE_TEST_DIR=${HIPACE_SOURCE_DIR}/tests
+
+FILE_NAME=`basename "$0"`
+TEST_NAME="${FILE_NAME%.*}"
+
+rm -rf ${TEST_NAME}_sync $TEST_NAME
+
+# Run the simulation with the synchronous writer
+mpiexec -n 2 $HIPACE_EXECUTABLE $HIPACE_EXAMPLE_DIR/inputs_normalized \
+        hipace.file_prefix=${TEST_NAME}_sync \
+        max_step=3
+
+# Run the simulation with the asynchronous writer
+mpiexec -n 2 $HIPACE_EXECUTABLE $HIPACE_EXAMPLE_DIR/inputs_normalized \
+        diagnostic.async_write = 1 \
+        hipace.file_prefix=$TEST_NAME \
+        max_step=3
+
+# Compare all fields and beam particle components of all iterations
+python3 - ${TEST_NAME}_sync $TEST_NAME <<'EOF_PY'
+import sys
+import numpy as np
+from openpmd_viewer import OpenPMDTimeSeries
+ts_sync = OpenPMDTimeSeries(sys.argv[1])
+ts_async = OpenPMDTimeSeries(sys.argv[2])
+assert(np.array_equal(ts_sync.iterations, ts_async.iterations))
+assert(ts_sync.avail_fields == ts_async.avail_fields)
+assert(ts_sync.avail_species == ts_async.avail_species)
+for iteration in ts_sync.iterations:
+    for field in ts_sync.avail_fields:
+        F_sync, _ = ts_sync.get_field(field=field, iteration=iteration)
+        F_async, _ = ts_async.get_field(field=field, iteration=iteration)
+        assert np.array_equal(F_sync, F_async), field + " differs at iteration " + str(iteration)
+    for species in ts_sync.avail_species:
+        for comp in ts_sync.avail_record_components[species]:
+            p_sync, = ts_sync.get_particle(species=species, iteration=iteration, var_list=[comp])
+            p_async, = ts_async.get_particle(species=species, iteration=iteration, var_list=[comp])
+            assert np.array_equal(p_sync, p_async), \
+                species + " " + comp + " differs at iteration " + str(iteration)
+print("The synchronous and asynchronous outputs are identical")
+EOF_PY
+
@@ -10,6 +10,7 @@ License: BSD-3-Clause-LBNL
 
 from checksum import Checksum
 from benchmark import Benchmark
+from timing import Timing, timing_cases
 import argparse
 import ast
 import glob
@@ -32,6 +33,13 @@ API for HiPACE++ checksum tests. It can be used in two ways:
   * Reset a benchmark. From a bash terminal:
     $ ./checksumAPI.py --reset-benchmark --file_name <path/to/file_name> \
                        --test-name <test name>
+
+- As a performance regression gate: run representative inputs repeatedly and
+  compare the median time per HIPACE_PROFILE region with the timing baselines.
+  * Evaluate all (or one, with --test-name) timing cases:
+    $ ./checksumAPI.py --benchmark --executable <path/to/hipace> \
+                       --source-dir <path/to/hipace/source>
+  * Record the baselines on the reference machine: add --reset-benchmark.
 '''
 
 
@@ -71,6 +79,33 @@ def reset_benchmark(test_name, file_name, do_fields=True, do_particles=True):
     ref_benchmark.reset()
 
 
+def evaluate_timing(test_names, executable, source_dir, repetitions=5,
+                    tolerance=0.3, min_time=0.01, reset=False):
+    '''Run timing cases and compare them with their baselines.
+
+    @param test_names Names of the timing cases, all if empty.
+    @param executable Path to the HiPACE++ executable.
+    @param source_dir Path to the HiPACE++ source directory.
+    @param repetitions Number of runs per case, the median time is compared.
+    @param tolerance Maximum relative slowdown per profiler region.
+    @param min_time Regions faster than this in the baseline [s] are not compared.
+    @param reset Whether to overwrite the baselines instead of comparing.
+    '''
+    failed = []
+    for test_name in (test_names or sorted(timing_cases)):
+        timing = Timing(test_name)
+        timing.run(executable, source_dir, repetitions)
+        if reset:
+            timing.reset()
+            continue
+        try:
+            timing.evaluate(tolerance, min_time)
+        except AssertionError as error:
+            print(error)
+            failed.append(test_name)
+    assert not failed, 'Performance regression in ' + ', '.join(failed)
+
+
 def reset_all_benchmarks(path_to_all_file_names):
     '''Update all benchmarks (overwrites reference json files)
     found in path_to_all_file_names
@@ -103,11 +138,13 @@ if __name__ == '__main__':
                         action='store_true', help='Reset a benchmark.')
     parser.add_argument('--test-name', dest='test_name', type=str, default='',
                         required='--evaluate' in sys.argv or
-                        '--reset-benchmark' in sys.argv,
+                        ('--reset-benchmark' in sys.argv and
+                         '--benchmark' not in sys.argv),
                         help='Name of the test (as in WarpX-tests.ini)')
     parser.add_argument('--file_name', dest='file_name', type=str, default='',
                         required='--evaluate' in sys.argv or
-                        '--reset-benchmark' in sys.argv,
+                        ('--reset-benchmark' in sys.argv and
+                         '--benchmark' not in sys.argv),
                         help='Name of IO file')
 
     parser.add_argument('--skip-fields', dest='do_fields',
@@ -139,8 +176,35 @@ if __name__ == '__main__':
                         typically WarpX-benchmarks generated by \
                         regression_testing/regtest.py')
 
+    # Options relevant to the performance regression gate
+    parser.add_argument('--benchmark', dest='benchmark', action='store_true',
+                        default=False,
+                        help='Compare run times with the timing baselines.')
+    parser.add_argument('--executable', dest='executable', type=str,
+                        default='', required='--benchmark' in sys.argv,
+                        help='HiPACE++ executable to time')
+    parser.add_argument('--source-dir', dest='source_dir', type=str,
+                        default='', required='--benchmark' in sys.argv,
+                        help='HiPACE++ source directory, for the inputs')
+    parser.add_argument('--repetitions', dest='repetitions', type=int,
+                        default=5, help='number of runs per timing case')
+    parser.add_argument('--tolerance', dest='tolerance', type=float,
+                        default=0.3,
+                        help='maximum relative slowdown per profiler region')
+    parser.add_argument('--min-time', dest='min_time', type=float,
+                        default=0.01,
+                        help='regions faster than this [s] are not compared')
+
     args = parser.parse_args()
 
+    if args.benchmark:
+        evaluate_timing([args.test_name] if args.test_name else [],
+                        args.executable, args.source_dir,
+                        repetitions=args.repetitions,
+                        tolerance=args.tolerance, min_time=args.min_time,
+                        reset=args.reset_benchmark)
+        sys.exit()
+
     if args.reset_benchmark:
         reset_benchmark(args.test_name, args.file_name,
                         do_fields=args.do_fields,
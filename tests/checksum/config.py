@@ -8,3 +8,4 @@ License: BSD-3-Clause-LBNL
 import os
 
 benchmark_location = os.path.split(__file__)[0] + '/benchmarks_json'
+timing_location = os.path.split(__file__)[0] + '/timing_json'
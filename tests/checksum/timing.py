@@ -0,0 +1,156 @@
+"""
+This file is part of the HiPACE++ test suite.
+
+License: BSD-3-Clause-LBNL
+"""
+import config
+import json
+import os
+import re
+import statistics
+import subprocess
+
+
+# Representative inputs for the performance regression gate.
+# Each entry: input file relative to the source directory, number of MPI ranks,
+# and additional runtime parameters. I/O is switched off, so only the solver is timed.
+timing_cases = {
+    'blowout_wake': {
+        'input': 'examples/blowout_wake/inputs_normalized',
+        'nprocs': 2,
+        'args': ['max_step=1'],
+    },
+    'linear_wake': {
+        'input': 'examples/linear_wake/inputs_normalized',
+        'nprocs': 1,
+        'args': [],
+    },
+    'ionization': {
+        'input': 'examples/blowout_wake/inputs_ionization_SI',
+        'nprocs': 2,
+        'args': ['hipace.dt=1e-12', 'max_step=2'],
+    },
+    'beam_evolution': {
+        'input': 'examples/beam_in_vacuum/inputs_normalized',
+        'nprocs': 1,
+        'args': ['amr.n_cell=32 32 10', 'max_step=20',
+                 'geometry.prob_lo=-2. -2. -2.', 'geometry.prob_hi=2. 2. 2.',
+                 'hipace.dt=3.', 'beam.density=1.e-8', 'beam.radius=1.',
+                 'beam.ppc=4 4 1', 'hipace.external_ExmBy_slope=.5'],
+    },
+}
+
+# One line of the inclusive TinyProfiler table:
+# name, number of calls, min, avg and max time over ranks, max percentage
+profiler_line = re.compile(
+    r'^(\S.*?)\s+(\d+)\s+(\S+)\s+(\S+)\s+(\S+)\s+(\S+)%$')
+
+
+def parse_tiny_profiler(output):
+    '''Return the inclusive time per HIPACE_PROFILE region, maximum over ranks.
+
+    @param output Standard output of a HiPACE++ run built with the TinyProfiler.
+    '''
+    regions = {}
+    in_table = False
+    for line in output.splitlines():
+        line = line.strip()
+        if line.startswith('Name') and 'Incl. Max' in line:
+            in_table = True
+            continue
+        if not in_table or line.startswith('---'):
+            continue
+        if line == '':
+            if regions:
+                break
+            continue
+        match = profiler_line.match(line)
+        if match:
+            regions[match.group(1)] = float(match.group(5))
+    if not regions:
+        raise RuntimeError('No TinyProfiler output found, '
+                           'HiPACE++ must be built with AMReX_TINY_PROFILE=ON')
+    return regions
+
+
+class Timing:
+    '''Median wall time per profiler region of one timing case, and its baseline.
+    '''
+
+    def __init__(self, test_name):
+        '''Constructor
+
+        @param self The object pointer.
+        @param test_name Name of the timing case, a key of timing_cases.
+        '''
+        if test_name not in timing_cases:
+            raise KeyError('Unknown timing case ' + test_name + ', available: '
+                           + ', '.join(timing_cases))
+        self.test_name = test_name
+        self.json_file = os.path.join(config.timing_location,
+                                      self.test_name + '.json')
+        self.data = {}
+
+    def run(self, executable, source_dir, repetitions):
+        '''Run the case repeatedly and store the median time per region.
+
+        @param self The object pointer.
+        @param executable Path to the HiPACE++ executable.
+        @param source_dir Path to the HiPACE++ source directory.
+        @param repetitions Number of runs.
+        '''
+        case = timing_cases[self.test_name]
+        command = ['mpiexec', '-n', str(case['nprocs']), executable,
+                   os.path.join(source_dir, case['input'])] + case['args'] + \
+                  ['hipace.output_period=-1', 'hipace.verbose=0']
+        samples = {}
+        for _ in range(repetitions):
+            result = subprocess.run(command, check=True, stdout=subprocess.PIPE,
+                                    universal_newlines=True)
+            for name, time in parse_tiny_profiler(result.stdout).items():
+                samples.setdefault(name, []).append(time)
+        # a region missing from some runs is not comparable
+        self.data = {name: statistics.median(times)
+                     for name, times in samples.items() if len(times) == repetitions}
+
+    def evaluate(self, tolerance, min_time):
+        '''Compare the median times with the baseline, fail beyond tolerance.
+
+        @param self The object pointer.
+        @param tolerance Maximum relative slowdown per region.
+        @param min_time Regions faster than this in the baseline [s] are not compared,
+                        they are dominated by noise.
+        '''
+        if not os.path.isfile(self.json_file):
+            raise FileNotFoundError('No timing baseline ' + self.json_file + ', record it with '
+                                    '--benchmark --reset-benchmark on the reference machine')
+        with open(self.json_file) as infile:
+            baseline = json.load(infile)
+
+        failed = []
+        print('{}: region, baseline [s], median [s], ratio'.format(self.test_name))
+        for name, ref_time in sorted(baseline.items()):
+            if ref_time < min_time:
+                continue
+            if name not in self.data:
+                failed.append(name + ' (missing)')
+                continue
+            ratio = self.data[name]/ref_time
+            print('  {:<60s} {:10.4g} {:10.4g} {:6.2f}'.format(
+                name, ref_time, self.data[name], ratio))
+            if ratio > 1. + tolerance:
+                failed.append('{} ({:.2f}x)'.format(name, ratio))
+
+        assert not failed, 'Performance regression in ' + self.test_name + ': ' + \
+            ', '.join(failed)
+        print('{}: no performance regression'.format(self.test_name))
+
+    def reset(self):
+        '''Update the baseline (overwrites reference json file).
+
+        @param self The object pointer.
+        '''
+        os.makedirs(config.timing_location, exist_ok=True)
+        with open(self.json_file, 'w') as outfile:
+            json.dump(self.data, outfile, sort_keys=True, indent=2)
+        print('timing baseline of {} reset successfully.'.format(self.test_name))
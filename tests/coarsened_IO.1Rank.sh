@@ -0,0 +1,30 @@
+#! /usr/bin/env bash
+
+# This file is part of the HiPACE++ test suite.
+# It runs a Hipace simulation with full IO and with coarsened IO, and checks that the coarsened
+# fields are the average of the full fields.
+
+# abort on first encounted error
+set -eu -o pipefail
+
+# Read input parameters
+HIPACE_EXECUTABLE=$1
+HIPACE_SOURCE_DIR=$2
+
+HIPACE_EXAMPLE_DIR=${HIPACE_SOURCE_DIR}/examples/blowout_wake
+HIPACE_TEST_DIR=${HIPACE_SOURCE_DIR}/tests
+
+# Run the simulation
+mpiexec -n 1 $HIPACE_EXECUTABLE $HIPACE_EXAMPLE_DIR/inputs_normalized \
+        diagnostic.diag_type=xyz \
+        amr.n_cell = 64 86 100 \
+        hipace.file_prefix=full_io
+
+mpiexec -n 1 $HIPACE_EXECUTABLE $HIPACE_EXAMPLE_DIR/inputs_normalized \
+        diagnostic.diag_type=xyz \
+        diagnostic.coarsening = 2 2 2 \
+        amr.n_cell = 64 86 100 \
+        hipace.file_prefix=coarse_io
+
+# assert whether the coarsened fields match the averaged full fields
+$HIPACE_EXAMPLE_DIR/analysis_coarsened_IO.py
@@ -0,0 +1,111 @@
+#! /usr/bin/env bash
+
+# This file is part of the HiPACE++ test suite.
+# It runs the grid_current.1Rank simulation with the grid current read from tabulated files
+# instead of the Gaussian profile. The tables sample the same Gaussian at the slice positions and
+# the cell centers, so the result must match the grid_current.1Rank benchmark. A second run with
+# a tabulated current and a Gaussian transverse profile checks the normalization of the latter.
+
+# abort on first encounted error
+set -eu -o pipefail
+
+# Read input parameters
+HIPACE_EXECUTABLE=$1
+HIPACE_SOURCE_DIR=$2
+
+HIPACE_EXAMPLE_DIR=${HIPACE_SOURCE_DIR}/examples/beam_in_vacuum
+HIPACE_TEST_DIR=${HIPACE_SOURCE_DIR}/tests
+
+FILE_NAME=`basename "$0"`
+TEST_NAME="${FILE_NAME%.*}"
+
+# Tables of the Gaussian grid current of grid_current.1Rank: peak current density 0.2, rms size
+# 0.3 0.3 1.41, on the 32^3 grid from -8 -8 -6 to 8 8 6. The transverse table is sampled at the
+# cell centers, the current I(z) at the slice positions and scaled by the discrete integral of
+# the transverse table, so the normalized profile reproduces the peak current density.
+python3 - ${TEST_NAME} <<'EOF'
+import math, sys
+name = sys.argv[1]
+n, dx, dz = 32, 0.5, 0.375
+sx, sy, sz, peak = 0.3, 0.3, 1.41, 0.2
+xc = [-8. + (i+0.5)*dx for i in range(n)]
+# values below 1e-30 are written as 0, so the table can also be read in single precision
+T = [[math.exp(-0.5*((x/sx)**2 + (y/sy)**2)) for x in xc] for y in xc]
+T = [[v if v > 1.e-30 else 0. for v in row] for row in T]
+integral = 0.
+for j in range(n):
+    for i in range(n):
+        w = (0.5 if i in (0, n-1) else 1.) * (0.5 if j in (0, n-1) else 1.)
+        integral += w*T[j][i]
+integral *= dx*dx
+with open(name + '_transverse.txt', 'w') as f:
+    f.write('# nx ny xmin xmax ymin ymax\n')
+    f.write('{} {} {!r} {!r} {!r} {!r}\n'.format(n, n, xc[0], xc[-1], xc[0], xc[-1]))
+    for row in T:
+        f.write(' '.join(repr(v) for v in row) + '\n')
+with open(name + '_current.txt', 'w') as f:
+    f.write('# z I\n')
+    for k in range(n+1):
+        z = -6. + k*dz
+        f.write('{!r} {!r}\n'.format(z, peak*integral*math.exp(-0.5*(z/sz)**2)))
+# the Gaussian transverse profile is normalized by its continuous integral 2 pi sx sy
+with open(name + '_current_gaussian.txt', 'w') as f:
+    f.write('# z I\n')
+    for k in range(n+1):
+        z = -6. + k*dz
+        f.write('{!r} {!r}\n'.format(
+            z, peak*2.*math.pi*sx*sy*math.exp(-0.5*(z/sz)**2)))
+EOF
+
+# Run the simulation with both profiles from file
+mpiexec -n 1 $HIPACE_EXECUTABLE $HIPACE_EXAMPLE_DIR/inputs_normalized \
+        amr.n_cell = 32 32 32 \
+        max_step = 1 \
+        hipace.depos_order_xy = 0 \
+        geometry.prob_lo = -8. -8. -6. \
+        geometry.prob_hi =  8.  8.  6. \
+        grid_current.use_grid_current = 1 \
+        grid_current.longitudinal_profile = from_file \
+        grid_current.current_file = ${TEST_NAME}_current.txt \
+        grid_current.transverse_profile = from_file \
+        grid_current.transverse_file = ${TEST_NAME}_transverse.txt \
+        hipace.output_period = 1 \
+        beam.profile = gaussian \
+        beam.position_std = 0.3 0.3 1.41 \
+        beam.density = 0.2 \
+        beam.radius = 1. \
+        beam.ppc = 1 1 1 \
+        hipace.file_prefix=$TEST_NAME
+
+# Compare the result with theory
+$HIPACE_EXAMPLE_DIR/analysis_grid_current.py --output-dir=$TEST_NAME
+
+# Compare the results with the checksum benchmark of the Gaussian grid current, up to round-off
+$HIPACE_TEST_DIR/checksum/checksumAPI.py \
+    --evaluate \
+    --file_name $TEST_NAME \
+    --test-name grid_current.1Rank \
+    --rtol 1.e-6
+
+# Run the simulation with a tabulated current and a Gaussian transverse profile
+mpiexec -n 1 $HIPACE_EXECUTABLE $HIPACE_EXAMPLE_DIR/inputs_normalized \
+        amr.n_cell = 32 32 32 \
+        max_step = 1 \
+        hipace.depos_order_xy = 0 \
+        geometry.prob_lo = -8. -8. -6. \
+        geometry.prob_hi =  8.  8.  6. \
+        grid_current.use_grid_current = 1 \
+        grid_current.longitudinal_profile = from_file \
+        grid_current.current_file = ${TEST_NAME}_current_gaussian.txt \
+        grid_current.position_mean = 0. 0. 0. \
+        grid_current.position_std = 0.3 0.3 1.41 \
+        hipace.output_period = 1 \
+        beam.profile = gaussian \
+        beam.position_std = 0.3 0.3 1.41 \
+        beam.density = 0.2 \
+        beam.radius = 1. \
+        beam.ppc = 1 1 1 \
+        hipace.file_prefix=${TEST_NAME}_gaussian
+
+# Compare the result with theory
+$HIPACE_EXAMPLE_DIR/analysis_grid_current.py --output-dir=${TEST_NAME}_gaussian
@@ -0,0 +1,41 @@
+#! /usr/bin/env bash
+
+# This file is part of the HiPACE++ test suite.
+# It runs a Hipace simulation in neutral hydrogen that gets ionized by the beam, without and with
+# an ionization probability cutoff, which skips the ions and the slices where the field is too
+# weak to ionize, and checks that both runs create the same number of electrons.
+
+# abort on first encounted error
+set -eu -o pipefail
+
+# Read input parameters
+HIPACE_EXECUTABLE=$1
+HIPACE_SOURCE_DIR=$2
+
+HIPACE_EXAMPLE_DIR=${HIPACE_SOURCE_DIR}/examples/blowout_wake
+HIPACE_TEST_DIR=${HIPACE_SOURCE_DIR}/tests
+
+FILE_NAME=`basename "$0"`
+TEST_NAME="${FILE_NAME%.*}"
+
+rm -rf ${TEST_NAME}_reference $TEST_NAME
+
+# Run the simulation evaluating the ionization rate everywhere
+mpiexec -n 1 $HIPACE_EXECUTABLE $HIPACE_EXAMPLE_DIR/inputs_ionization_SI \
+        hipace.dt = 1e-12 \
+        hipace.output_period = 1 \
+        hipace.file_prefix=${TEST_NAME}_reference \
+        max_step=2
+
+# Run the simulation with an ionization probability cutoff
+mpiexec -n 1 $HIPACE_EXECUTABLE $HIPACE_EXAMPLE_DIR/inputs_ionization_SI \
+        hipace.dt = 1e-12 \
+        hipace.output_period = 1 \
+        ion.ionization_probability_cutoff = 1.e-8 \
+        hipace.file_prefix=$TEST_NAME \
+        max_step=2
+
+# Compare the number of ionized electrons
+$HIPACE_EXAMPLE_DIR/analysis_ionization.py \
+        --reference=${TEST_NAME}_reference \
+        --output=$TEST_NAME
@@ -0,0 +1,49 @@
+#! /usr/bin/env bash
+
+# This file is part of the HiPACE++ test suite.
+# It runs a beam in vacuum twice, without and with the beam output filters output_zmin,
+# output_zmax, output_id_stride and output_fraction, and checks the filtered particles.
+
+# abort on first encounted error
+set -eu -o pipefail
+
+# Read input parameters
+HIPACE_EXECUTABLE=$1
+HIPACE_SOURCE_DIR=$2
+
+HIPACE_EXAMPLE_DIR=${HIPACE_SOURCE_DIR}/examples/beam_in_vacuum
+HIPACE_TEST_DIR=${HIPACE_SOURCE_DIR}/tests
+
+FILE_NAME=`basename "$0"`
+TEST_NAME="${FILE_NAME%.*}"
+
+COMMON_ARGS="amr.n_cell = 32 32 32 \
+             max_step = 1 \
+             geometry.prob_lo = -4. -4. -4. \
+             geometry.prob_hi =  4.  4.  4. \
+             beam.zmin = -3. \
+             beam.zmax = 3. \
+             beam.radius = 1.5"
+
+# Run the simulation without filters
+mpiexec -n 1 $HIPACE_EXECUTABLE $HIPACE_EXAMPLE_DIR/inputs_normalized \
+        $COMMON_ARGS \
+        hipace.file_prefix=${TEST_NAME}_reference
+
+# Run the simulation with filters
+mpiexec -n 1 $HIPACE_EXECUTABLE $HIPACE_EXAMPLE_DIR/inputs_normalized \
+        $COMMON_ARGS \
+        beam.output_zmin = -1.5 \
+        beam.output_zmax = 2. \
+        beam.output_id_stride = 3 \
+        beam.output_fraction = 0.5 \
+        hipace.file_prefix=$TEST_NAME
+
+# Compare the filtered beam with the full beam
+$HIPACE_EXAMPLE_DIR/analysis_output_filter.py \
+    --reference=${TEST_NAME}_reference \
+    --filtered=$TEST_NAME \
+    --zmin=-1.5 \
+    --zmax=2. \
+    --id-stride=3 \
+    --fraction=0.5
@@ -0,0 +1,19 @@
+#! /usr/bin/env bash
+
+# This file is part of the HiPACE++ test suite.
+# It runs representative inputs repeatedly and compares the median time per
+# HIPACE_PROFILE region with the timing baselines recorded on the reference machine.
+
+# abort on first encounted error
+set -eu -o pipefail
+
+# Read input parameters
+HIPACE_EXECUTABLE=$1
+HIPACE_SOURCE_DIR=$2
+
+HIPACE_TEST_DIR=${HIPACE_SOURCE_DIR}/tests
+
+$HIPACE_TEST_DIR/checksum/checksumAPI.py \
+    --benchmark \
+    --executable $HIPACE_EXECUTABLE \
+    --source-dir $HIPACE_SOURCE_DIR
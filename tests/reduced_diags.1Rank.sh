@@ -0,0 +1,29 @@
+#! /usr/bin/env bash
+
+# This file is part of the HiPACE++ test suite.
+# It runs a Hipace simulation with full IO and in-situ reduced diagnostics, and checks that
+# the per-slice beam moments and the on-axis field lineouts match the full output.
+
+# abort on first encounted error
+set -eu -o pipefail
+
+# Read input parameters
+HIPACE_EXECUTABLE=$1
+HIPACE_SOURCE_DIR=$2
+
+HIPACE_EXAMPLE_DIR=${HIPACE_SOURCE_DIR}/examples/blowout_wake
+HIPACE_TEST_DIR=${HIPACE_SOURCE_DIR}/tests
+
+FILE_NAME=`basename "$0"`
+TEST_NAME="${FILE_NAME%.*}"
+
+# Run the simulation
+mpiexec -n 1 $HIPACE_EXECUTABLE $HIPACE_EXAMPLE_DIR/inputs_normalized \
+        max_step = 1 \
+        diagnostic.reduced_period = 1 \
+        diagnostic.reduced_file_prefix = ${TEST_NAME}_reduced \
+        hipace.file_prefix = $TEST_NAME
+
+# Compare the reduced diagnostics with the full output
+$HIPACE_EXAMPLE_DIR/analysis_reduced_diags.py --output-dir=$TEST_NAME \
+        --reduced-dir=${TEST_NAME}_reduced
@@ -0,0 +1,33 @@
+#! /usr/bin/env bash
+
+# This file is part of the HiPACE++ test suite.
+# It runs the blowout_wake.2Rank simulation in normalized units with the beam particles moved in
+# slice order, so the slice kernels and the ghost particle communication skip the bin permutation.
+# Only the summation order changes, so the result must match the benchmark up to round-off.
+
+# abort on first encounted error
+set -eu -o pipefail
+
+# Read input parameters
+HIPACE_EXECUTABLE=$1
+HIPACE_SOURCE_DIR=$2
+
+HIPACE_EXAMPLE_DIR=${HIPACE_SOURCE_DIR}/examples/blowout_wake
+HIPACE_TEST_DIR=${HIPACE_SOURCE_DIR}/tests
+
+FILE_NAME=`basename "$0"`
+TEST_NAME="${FILE_NAME%.*}"
+
+# Run the simulation
+mpiexec -n 2 $HIPACE_EXECUTABLE $HIPACE_EXAMPLE_DIR/inputs_normalized \
+        beams.reorder_by_slice = 1 \
+        hipace.file_prefix=$TEST_NAME \
+        max_step=1
+
+# Compare the results with the checksum benchmark of the run without reordering
+$HIPACE_TEST_DIR/checksum/checksumAPI.py \
+    --evaluate \
+    --file_name $TEST_NAME \
+    --test-name blowout_wake.2Rank \
+    --skip "{'beam': 'id'}" \
+    --rtol 1.e-6
@@ -0,0 +1,41 @@
+#! /usr/bin/env bash
+
+# This file is part of the HiPACE++ test suite.
+# It runs a Hipace simulation in the blowout regime writing native checkpoints, restarts it
+# from a checkpoint, and checks that the beam at the last step is the same in both runs.
+
+# abort on first encounted error
+set -eu -o pipefail
+
+# Read input parameters
+HIPACE_EXECUTABLE=$1
+HIPACE_SOURCE_DIR=$2
+
+HIPACE_EXAMPLE_DIR=${HIPACE_SOURCE_DIR}/examples/blowout_wake
+HIPACE_TEST_DIR=${HIPACE_SOURCE_DIR}/tests
+
+FILE_NAME=`basename "$0"`
+TEST_NAME="${FILE_NAME%.*}"
+
+# Run the simulation, with a checkpoint at step 2
+mpiexec -n 1 $HIPACE_EXECUTABLE $HIPACE_EXAMPLE_DIR/inputs_normalized \
+        max_step = 4 \
+        hipace.dt = 10. \
+        hipace.output_period = 4 \
+        hipace.checkpoint_period = 2 \
+        hipace.checkpoint_prefix = ${TEST_NAME}_chk \
+        hipace.file_prefix = ${TEST_NAME}_1
+
+# Restart the simulation from the checkpoint
+mpiexec -n 1 $HIPACE_EXECUTABLE $HIPACE_EXAMPLE_DIR/inputs_normalized \
+        max_step = 4 \
+        hipace.dt = 10. \
+        hipace.output_period = 4 \
+        hipace.restart_from = ${TEST_NAME}_chk/chk000002 \
+        hipace.file_prefix = ${TEST_NAME}_2
+
+# Compare the beams at the last step
+${HIPACE_SOURCE_DIR}/examples/beam_in_vacuum/analysis_from_file.py \
+        --beam-out1 ${TEST_NAME}_1/openpmd_%T.h5 \
+        --beam-out2 ${TEST_NAME}_2/openpmd_%T.h5 \
+        --iteration 4